@@ -0,0 +1,14 @@
+# Builds the editor, the command line tool, the tests and the benchmarks together. `make check` runs the tests and
+# the benchmarks, which need QT_QPA_PLATFORM=offscreen where there is no display.
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    app \
+    spritec \
+    tests \
+    benchmarks
+
+app.file = SpriteEditor/SpriteEditor.pro
+spritec.file = SpriteEditor/spritec/spritec.pro
+tests.file = SpriteEditor/tests/tests.pro
+benchmarks.file = SpriteEditor/benchmarks/benchmarks.pro
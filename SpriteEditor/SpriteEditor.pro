@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 
 CONFIG += c++17
 
@@ -9,15 +9,44 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    autosavejournal.cpp \
+    canvasitem.cpp \
     frameeditor.cpp \
+    framepool.cpp \
+    framestore.cpp \
     main.cpp \
     mainwindow.cpp \
-    model.cpp
+    model.cpp \
+    pixelkernels.cpp \
+    previewcache.cpp \
+    previewclock.cpp \
+    projectfile.cpp \
+    sspbfile.cpp \
+    sspreader.cpp \
+    sspwriter.cpp \
+    stamp.cpp \
+    trace.cpp \
+    undohistory.cpp
 
 HEADERS += \
+    autosavejournal.h \
+    canvasitem.h \
     frameeditor.h \
+    fileprogress.h \
+    framepool.h \
+    framestore.h \
     mainwindow.h \
-    model.h
+    model.h \
+    pixelkernels.h \
+    previewcache.h \
+    previewclock.h \
+    projectfile.h \
+    sspbfile.h \
+    sspreader.h \
+    sspwriter.h \
+    stamp.h \
+    trace.h \
+    undohistory.h
 
 FORMS += \
     frameeditor.ui \
@@ -0,0 +1,382 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "autosavejournal.h"
+#include "sspreader.h"
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+static const char magic[4] = { 'S', 'S', 'P', 'J' };
+static const quint32 formatVersion = 1;
+static const qint64 headerBytes = 8;
+static const qint64 recordHeaderBytes = 24;
+static const qint64 pixelsHeadBytes = 16;
+static const qint64 referenceHeadBytes = 24;
+static const qint64 layoutHeadBytes = 8;
+static const quint32 pixelsRecord = 1;
+static const quint32 layoutRecord = 2;
+static const quint32 referenceRecord = 3;
+static const int maxFrameSize = 4096;
+
+// A journal smaller than this is never compacted, however much of it is stale
+static const qint64 minimumCompactBytes = 4 * 1024 * 1024;
+
+//!
+//! \brief checksum Adds bytes to a 64 bit FNV-1a hash, which catches a record that was only partly written
+//! \param hash The hash so far
+//! \param data The bytes to add
+//! \param length How many bytes there are
+//! \return The new hash
+//!
+static quint64 checksum(quint64 hash, const char *data, qint64 length) {
+    for (qint64 i = 0; i < length; i++)
+        hash = (hash ^ uchar(data[i])) * 1099511628211ULL;
+    return hash;
+}
+
+static const quint64 checksumStart = 14695981039346656037ULL;
+
+//!
+//! \brief writeRecord Writes one record, its payload being a small head followed by any number of pixel bytes
+//! \param device The journal
+//! \param type What kind of record it is
+//! \param head The start of the payload
+//! \param bytes The rest of the payload, may be null
+//! \param length How many bytes the rest is
+//! \return Whether the whole record was written
+//!
+static bool writeRecord(QIODevice &device, quint32 type, const QByteArray &head, const char *bytes, qint64 length) {
+    uchar header[recordHeaderBytes] = {};
+    qToLittleEndian<quint32>(type, header);
+    qToLittleEndian<quint64>(head.size() + length, header + 8);
+    qToLittleEndian<quint64>(checksum(checksum(checksumStart, head.constData(), head.size()), bytes, length), header + 16);
+
+    return device.write(reinterpret_cast<const char *>(header), recordHeaderBytes) == recordHeaderBytes
+        && device.write(head) == head.size()
+        && (length == 0 || device.write(bytes, length) == length);
+}
+
+//!
+//! \brief syncToDisk Waits until what was flushed to a file is on the disk, not just in the operating system's cache
+//! \param file The open file
+//! \return Whether it was synced
+//!
+static bool syncToDisk(QFile &file) {
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+//!
+//! \brief AutosaveJournal::AutosaveJournal Constructor, nothing is written until the first checkpoint
+//! \param filename The journal file (includes path)
+//!
+AutosaveJournal::AutosaveJournal(const QString &filename) : filename(filename), liveBytes(0) {
+}
+
+//!
+//! \brief AutosaveJournal::checkpoint Appends the frames drawn on since the last checkpoint and the current layout.
+//!        The first checkpoint, or the first after a failed one or after a file it refers to changed, writes a fresh
+//!        journal instead, which replaces the old one only once it is complete. Only one thread may checkpoint at a
+//!        time, and the frames must not change while it runs, so pass a snapshot.
+//! \param frames The frames to checkpoint
+//! \return Whether the checkpoint was written
+//!
+bool AutosaveJournal::checkpoint(const FrameStore &frames) {
+    if (!file.isOpen() || referencesChanged())
+        return compact(frames);
+
+    if (!appendFrames(file, frames) || !file.flush() || !syncToDisk(file)) {
+        // Whatever was half written is ignored when recovering, and the next checkpoint starts a fresh journal
+        file.close();
+        written.clear();
+        return false;
+    }
+
+    if (file.size() > qMax(minimumCompactBytes, 2 * liveBytes))
+        return compact(frames);
+    return true;
+}
+
+//!
+//! \brief AutosaveJournal::remove Deletes the journal, used once there is nothing left to recover
+//!
+void AutosaveJournal::remove() {
+    file.close();
+    written.clear();
+    referenced.clear();
+    QFile::remove(filename);
+}
+
+//!
+//! \brief AutosaveJournal::setAside Renames the journal to its backup name, replacing an older backup, so a journal
+//!        that could not be recovered is kept for the user rather than overwritten by the next checkpoint
+//! \return Whether the journal was renamed
+//!
+bool AutosaveJournal::setAside() {
+    file.close();
+    written.clear();
+    referenced.clear();
+    QFile::remove(backupFileName());
+    return QFile::rename(filename, backupFileName());
+}
+
+//!
+//! \brief AutosaveJournal::compact Rewrites the journal holding only the frames given. It is written to a temporary
+//!        file, which QSaveFile syncs before renaming it over the old journal, so a crash while compacting still
+//!        leaves the old one to recover.
+//! \param frames The frames to keep
+//! \return Whether the journal was rewritten
+//!
+bool AutosaveJournal::compact(const FrameStore &frames) {
+    file.close();
+    written.clear();
+    referenced.clear();
+
+    QSaveFile fresh(filename);
+    if (!fresh.open(QIODevice::WriteOnly))
+        return false;
+
+    uchar header[headerBytes] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    qToLittleEndian<quint32>(formatVersion, header + 4);
+    if (fresh.write(reinterpret_cast<const char *>(header), headerBytes) != headerBytes
+        || !appendFrames(fresh, frames) || !fresh.commit()) {
+        written.clear();
+        return false;
+    }
+
+    // Later checkpoints append to it
+    file.setFileName(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        written.clear();
+        return false;
+    }
+    return true;
+}
+
+//!
+//! \brief AutosaveJournal::appendFrames Writes every frame whose version is not in the journal yet, then the layout.
+//!        Frames sharing a version, such as duplicated frames, are written once. A frame not decoded yet from a file
+//!        is written as a reference to it, without decoding it.
+//! \param device The journal
+//! \param frames The frames to write
+//! \return Whether everything was written
+//!
+bool AutosaveJournal::appendFrames(QIODevice &device, const FrameStore &frames) {
+    int frameCount = frames.frameCount();
+    QByteArray layout(layoutHeadBytes + 8 * qsizetype(frameCount), '\0');
+    qToLittleEndian<quint32>(frames.size(), layout.data());
+    qToLittleEndian<quint32>(frameCount, layout.data() + 4);
+
+    std::unordered_set<quint64> live;
+    QHash<QString, bool> unchanged;
+    liveBytes = headerBytes + recordHeaderBytes + layout.size();
+    for (int i = 0; i < frameCount; i++) {
+        quint64 version = frames.version(i);
+        qToLittleEndian<quint64>(version, layout.data() + layoutHeadBytes + 8 * qsizetype(i));
+        if (!live.insert(version).second)
+            continue;
+        auto found = written.find(version);
+        if (found != written.end()) {
+            liveBytes += found->second;
+            continue;
+        }
+
+        // A file changed since it was opened no longer holds the frame, so it is decoded from what was read instead
+        int sourceFrame = 0;
+        std::shared_ptr<const FrameSource> source = frames.source(i, &sourceFrame);
+        QString sourceName = source ? source->fileName() : QString();
+        if (!sourceName.isEmpty() && !unchanged.contains(sourceName))
+            unchanged.insert(sourceName, SspReader::currentStamp(sourceName) == source->fileStamp());
+        if (!sourceName.isEmpty() && !unchanged.value(sourceName))
+            sourceName.clear();
+
+        QByteArray head;
+        bool ok;
+        if (!sourceName.isEmpty()) {
+            QByteArray stamp = source->fileStamp();
+            QByteArray name = sourceName.toUtf8();
+            head = QByteArray(referenceHeadBytes, '\0');
+            qToLittleEndian<quint64>(version, head.data());
+            qToLittleEndian<quint32>(frames.size(), head.data() + 8);
+            qToLittleEndian<quint32>(sourceFrame, head.data() + 12);
+            qToLittleEndian<quint32>(stamp.size(), head.data() + 16);
+            qToLittleEndian<quint32>(name.size(), head.data() + 20);
+            head += stamp + name;
+            referenced.insert(sourceName, stamp);
+            ok = writeRecord(device, referenceRecord, head, nullptr, 0);
+        } else {
+            head = QByteArray(pixelsHeadBytes, '\0');
+            qToLittleEndian<quint64>(version, head.data());
+            qToLittleEndian<quint32>(frames.size(), head.data() + 8);
+            ok = writeRecord(device, pixelsRecord, head, reinterpret_cast<const char *>(frames.constBits(i)), frames.frameBytes());
+        }
+        if (!ok)
+            return false;
+
+        qint64 bytes = recordHeaderBytes + head.size() + (sourceName.isEmpty() ? frames.frameBytes() : 0);
+        written.emplace(version, bytes);
+        liveBytes += bytes;
+    }
+
+    return writeRecord(device, layoutRecord, layout, nullptr, 0);
+}
+
+//!
+//! \brief AutosaveJournal::referencesChanged Checks whether a file frames in the journal refer to has been changed
+//!        or removed since it was opened, such as by saving over it, so the references no longer hold
+//! \return Whether any file has changed
+//!
+bool AutosaveJournal::referencesChanged() const {
+    for (auto i = referenced.constBegin(); i != referenced.constEnd(); ++i) {
+        if (SspReader::currentStamp(i.key()) != i.value())
+            return true;
+    }
+    return false;
+}
+
+//!
+//! \brief AutosaveJournal::recover Restores the frames from the last complete checkpoint in a journal
+//! \param filename The journal file (includes path)
+//! \param frames The store to replace with the recovered frames, left alone if nothing could be recovered
+//! \param error Set to the reason nothing could be recovered
+//! \return Whether frames were recovered
+//!
+bool AutosaveJournal::recover(const QString &filename, FrameStore &frames, QString *error) {
+    auto fail = [error](const QString &message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    QFile in(filename);
+    if (!in.open(QIODevice::ReadOnly))
+        return fail("Unable to open " + filename);
+
+    qint64 fileSize = in.size();
+    uchar *mapped = in.map(0, fileSize);
+    QByteArray contents;
+    const char *view = reinterpret_cast<const char *>(mapped);
+    if (!mapped) {
+        contents = in.readAll();
+        view = contents.constData();
+        fileSize = contents.size();
+    }
+
+    if (fileSize < headerBytes || std::memcmp(view, magic, sizeof(magic)) != 0 || qFromLittleEndian<quint32>(view + 4) != formatVersion)
+        return fail("The file is not an autosave journal");
+
+    //!
+    //! \brief Stored Where the pixels of, or the reference to, one version are in the journal
+    //!
+    struct Stored {
+        quint32 type;
+        quint32 size;
+        qint64 payload;
+    };
+
+    // The latest record for a version wins
+    std::unordered_map<quint64, Stored> stored;
+    vector<Stored> layout;
+    int layoutSize = 0;
+
+    qint64 pos = headerBytes;
+    while (fileSize - pos >= recordHeaderBytes) {
+        quint32 type = qFromLittleEndian<quint32>(view + pos);
+        quint64 length = qFromLittleEndian<quint64>(view + pos + 8);
+        quint64 sum = qFromLittleEndian<quint64>(view + pos + 16);
+        const char *payload = view + pos + recordHeaderBytes;
+
+        // A record cut short or not matching its checksum is where the editor stopped
+        if (length > quint64(fileSize - pos - recordHeaderBytes) || checksum(checksumStart, payload, length) != sum)
+            break;
+
+        if (type == pixelsRecord && qint64(length) >= pixelsHeadBytes) {
+            quint64 version = qFromLittleEndian<quint64>(payload);
+            qint64 size = qFromLittleEndian<quint32>(payload + 8);
+            if (size >= 1 && size <= maxFrameSize && qint64(length) == pixelsHeadBytes + size * size * qint64(sizeof(Pixel)))
+                stored[version] = Stored { type, quint32(size), pos + recordHeaderBytes };
+        } else if (type == referenceRecord && qint64(length) >= referenceHeadBytes) {
+            quint64 version = qFromLittleEndian<quint64>(payload);
+            quint32 size = qFromLittleEndian<quint32>(payload + 8);
+            qint64 stampBytes = qFromLittleEndian<quint32>(payload + 16);
+            qint64 nameBytes = qFromLittleEndian<quint32>(payload + 20);
+            if (size >= 1 && size <= (quint32)maxFrameSize && nameBytes > 0 && qint64(length) == referenceHeadBytes + stampBytes + nameBytes)
+                stored[version] = Stored { type, size, pos + recordHeaderBytes };
+        } else if (type == layoutRecord && qint64(length) >= layoutHeadBytes) {
+            quint32 size = qFromLittleEndian<quint32>(payload);
+            qint64 frameCount = qFromLittleEndian<quint32>(payload + 4);
+
+            // Only a layout whose every frame was written before it, at its size, can be restored
+            vector<Stored> entries;
+            if (size >= 1 && size <= (quint32)maxFrameSize && frameCount >= 1 && qint64(length) == layoutHeadBytes + 8 * frameCount) {
+                for (qint64 i = 0; i < frameCount; i++) {
+                    auto found = stored.find(qFromLittleEndian<quint64>(payload + layoutHeadBytes + 8 * i));
+                    if (found == stored.end() || found->second.size != size)
+                        break;
+                    entries.push_back(found->second);
+                }
+            }
+            if (qint64(entries.size()) == frameCount && frameCount > 0) {
+                layout = std::move(entries);
+                layoutSize = size;
+            }
+        }
+
+        pos += recordHeaderBytes + length;
+    }
+
+    if (layout.empty())
+        return fail("The journal has no complete checkpoint");
+
+    FrameStore recovered(layoutSize);
+    QHash<QString, std::shared_ptr<SspReader>> sources;
+    std::unordered_map<qint64, int> restored;
+    for (const Stored &entry : layout) {
+        // Frames that shared pixels when they were saved share them again
+        auto shared = restored.find(entry.payload);
+        if (shared != restored.end()) {
+            recovered.moveFrame(recovered.duplicateFrame(shared->second), recovered.frameCount() - 1);
+            continue;
+        }
+        restored.emplace(entry.payload, recovered.frameCount());
+
+        const char *payload = view + entry.payload;
+        if (entry.type == pixelsRecord) {
+            int frame = recovered.addFrame();
+            std::memcpy(recovered.bits(frame), payload + pixelsHeadBytes, recovered.frameBytes());
+            continue;
+        }
+
+        // A referenced frame is decoded from its file again when it is used, which must still be the file it was
+        int sourceFrame = qFromLittleEndian<quint32>(payload + 12);
+        qint64 stampBytes = qFromLittleEndian<quint32>(payload + 16);
+        qint64 nameBytes = qFromLittleEndian<quint32>(payload + 20);
+        QByteArray stamp(payload + referenceHeadBytes, stampBytes);
+        QString name = QString::fromUtf8(payload + referenceHeadBytes + stampBytes, nameBytes);
+        std::shared_ptr<SspReader> &reader = sources[name];
+        if (!reader) {
+            reader = std::make_shared<SspReader>();
+            if (!reader->open(name) || !reader->readHeader() || reader->fileStamp() != stamp || reader->size() != layoutSize)
+                return fail(name + " has changed since the frames were autosaved");
+        }
+        if (sourceFrame < 0 || sourceFrame >= reader->frameCount())
+            return fail(name + " has changed since the frames were autosaved");
+        recovered.addLazyFrame(reader, sourceFrame);
+    }
+
+    frames.swap(recovered);
+    return true;
+}
@@ -0,0 +1,65 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef AUTOSAVEJOURNAL_H
+#define AUTOSAVEJOURNAL_H
+
+#include "framestore.h"
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief AutosaveJournal An append-only file the editor checkpoints its frames into, so a crash or hang loses at
+//!        most the work since the last checkpoint. A checkpoint appends the raw pixels of every frame whose version
+//!        is not in the journal yet, which are only the frames drawn on since the last checkpoint, followed by a
+//!        layout listing the versions of every frame in order. A frame not decoded yet from the project it was
+//!        opened from is still exactly what that file holds, so only a reference to it is written, and opening a
+//!        large project does not decode every frame at the first checkpoint. Once the journal holds more than twice
+//!        the records of the frames it describes, or a file it refers to has changed, it is rewritten with only
+//!        those frames.
+//!
+//!        file: "SSPJ", version, then records of a 24 byte header (type, reserved, payload bytes, FNV-1a checksum of
+//!        the payload) and the payload. All integers are little endian.
+//!        pixels record: frame version, width and height, reserved, raw RGBA8 scanlines
+//!        reference record: frame version, width and height, frame number in the file, stamp bytes, file name bytes,
+//!        the file's size and modification time when it was opened, UTF-8 file name
+//!        layout record: width and height, frame count, the version of each frame
+//!
+//!        Every checkpoint is synced to the disk before it counts as written, so a power cut cannot leave a layout
+//!        whose frames never reached it. Recovering reads the records in order and stops at the first one that is cut short or fails its checksum,
+//!        such as one being written when the editor crashed, and restores the last complete layout before it. Frames
+//!        restored from a reference are decoded lazily from their file again, as long as it has not changed.
+//!
+class AutosaveJournal
+{
+public:
+    explicit AutosaveJournal(const QString &filename);
+
+    bool checkpoint(const FrameStore &frames);
+    void remove();
+    bool setAside();
+    QString fileName() const { return filename; }
+    QString backupFileName() const { return filename + ".bak"; }
+
+    static bool recover(const QString &filename, FrameStore &frames, QString *error = nullptr);
+
+private:
+    QString filename;
+    QFile file;
+    std::unordered_map<quint64, qint64> written;
+    QHash<QString, QByteArray> referenced;
+    qint64 liveBytes;
+
+    bool compact(const FrameStore &frames);
+    bool appendFrames(QIODevice &device, const FrameStore &frames);
+    bool referencesChanged() const;
+};
+
+#endif // AUTOSAVEJOURNAL_H
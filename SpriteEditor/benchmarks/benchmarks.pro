@@ -0,0 +1,53 @@
+QT       += core gui widgets concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = benchmarks
+
+# The benchmarks build the editor's own sources rather than linking the app
+INCLUDEPATH += ..
+
+# The sample project the load benchmarks open
+DEFINES += SNOWFLAKE_PATH=\\\"$$PWD/../../snowflake.ssp\\\"
+
+SOURCES += \
+    tst_benchmarks.cpp \
+    ../autosavejournal.cpp \
+    ../canvasitem.cpp \
+    ../frameeditor.cpp \
+    ../framepool.cpp \
+    ../framestore.cpp \
+    ../model.cpp \
+    ../pixelkernels.cpp \
+    ../previewcache.cpp \
+    ../previewclock.cpp \
+    ../projectfile.cpp \
+    ../sspbfile.cpp \
+    ../sspreader.cpp \
+    ../sspwriter.cpp \
+    ../stamp.cpp \
+    ../trace.cpp \
+    ../undohistory.cpp
+
+HEADERS += \
+    ../autosavejournal.h \
+    ../canvasitem.h \
+    ../frameeditor.h \
+    ../fileprogress.h \
+    ../framepool.h \
+    ../framestore.h \
+    ../model.h \
+    ../pixelkernels.h \
+    ../previewcache.h \
+    ../previewclock.h \
+    ../projectfile.h \
+    ../sspbfile.h \
+    ../sspreader.h \
+    ../sspwriter.h \
+    ../stamp.h \
+    ../trace.h \
+    ../undohistory.h
+
+FORMS += \
+    ../frameeditor.ui
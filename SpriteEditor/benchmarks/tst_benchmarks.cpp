@@ -0,0 +1,635 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include <QtTest>
+#include <QApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include "autosavejournal.h"
+#include "frameeditor.h"
+#include "framestore.h"
+#include "model.h"
+#include "pixelkernels.h"
+#include "previewcache.h"
+#include "projectfile.h"
+#include <cstring>
+
+//!
+//! \brief Benchmarks Times the editor's hot paths on every canvas size the editor offers: the pixel kernels on their
+//!        own, the tools as the editor runs them, loading and saving, and handing frames to the preview
+//!
+class Benchmarks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void floodFill_data();
+    void floodFill();
+    void replaceColor_data();
+    void replaceColor();
+    void upscale_data();
+    void upscale();
+    void loadFile_data();
+    void loadFile();
+    void saveFile_data();
+    void saveFile();
+    void autosaveCheckpoint_data();
+    void autosaveCheckpoint();
+    void fillDriver_data();
+    void fillDriver();
+    void fillAllDriver_data();
+    void fillAllDriver();
+    void drawStamp_data();
+    void drawStamp();
+    void drawSegment_data();
+    void drawSegment();
+    void flushDamage_data();
+    void flushDamage();
+    void previewFrame_data();
+    void previewFrame();
+
+private:
+    QTemporaryDir projects;
+    QString projectPath(int size, int frameCount, const QString &suffix) const;
+    void addCanvasSizeRows();
+};
+
+//!
+//! \brief fillPattern Fills every frame with a different, busy pattern so saved files are a realistic size
+//! \param frames The frames to fill
+//!
+static void fillPattern(FrameStore &frames) {
+    for (int frame = 0; frame < frames.frameCount(); frame++) {
+        for (int y = 0; y < frames.size(); y++) {
+            for (int x = 0; x < frames.size(); x++)
+                frames.setPixel(frame, x, y, packPixel((x * 7 + frame) & 0xff, (y * 13) & 0xff, (x ^ y) & 0xff, 255));
+        }
+    }
+}
+
+//!
+//! \brief Benchmarks::initTestCase Writes the synthetic projects the load benchmarks open
+//!
+void Benchmarks::initTestCase() {
+    QVERIFY(projects.isValid());
+    for (int size = 16; size <= 256; size *= 2) {
+        for (int frameCount : { 1, 8 }) {
+            FrameStore frames(size);
+            for (int i = 0; i < frameCount; i++)
+                frames.addFrame();
+            fillPattern(frames);
+            QVERIFY(ProjectFile::save(frames, projectPath(size, frameCount, "ssp")));
+            QVERIFY(ProjectFile::save(frames, projectPath(size, frameCount, "sspb")));
+        }
+    }
+}
+
+//!
+//! \brief Benchmarks::projectPath Gets where a synthetic project is written
+//!
+QString Benchmarks::projectPath(int size, int frameCount, const QString &suffix) const {
+    return projects.filePath(QString("%1x%1_%2.%3").arg(size).arg(frameCount).arg(suffix));
+}
+
+//!
+//! \brief Benchmarks::addCanvasSizeRows Adds one row for each canvas size the editor offers
+//!
+void Benchmarks::addCanvasSizeRows() {
+    QTest::addColumn<int>("size");
+    for (int size = 16; size <= 256; size *= 2)
+        QTest::newRow(qPrintable(QString("%1x%1").arg(size))) << size;
+}
+
+void Benchmarks::floodFill_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("diagonal");
+    for (int size = 16; size <= 256; size *= 2) {
+        QTest::newRow(qPrintable(QString("%1x%1 4-way").arg(size))) << size << false;
+        QTest::newRow(qPrintable(QString("%1x%1 8-way").arg(size))) << size << true;
+    }
+}
+
+//!
+//! \brief Benchmarks::floodFill Fills a whole empty canvas from its center, alternating colors so every pass
+//!        repaints every pixel
+//!
+void Benchmarks::floodFill() {
+    QFETCH(int, size);
+    QFETCH(bool, diagonal);
+
+    PixelKernels::FillOptions options;
+    options.diagonal = diagonal;
+    FrameStore frames(size);
+    int frame = frames.addFrame();
+    Pixel colors[2] = { packPixel(255, 0, 0, 255), packPixel(0, 0, 255, 255) };
+    int pass = 0;
+
+    // The whole canvas is one region, so the first fill must cover it exactly
+    QRect filled = PixelKernels::floodFill(frames.bits(frame), size, QPoint(size / 2, size / 2), colors[pass++ % 2], options);
+    QCOMPARE(filled, QRect(0, 0, size, size));
+
+    QBENCHMARK {
+        PixelKernels::floodFill(frames.bits(frame), size, QPoint(size / 2, size / 2), colors[pass++ % 2], options);
+    }
+}
+
+void Benchmarks::replaceColor_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("frameCount");
+    for (int size = 16; size <= 256; size *= 2)
+        QTest::newRow(qPrintable(QString("%1x%1").arg(size))) << size << 1;
+    QTest::newRow("256x256 200 frames") << 256 << 200;
+}
+
+//!
+//! \brief Benchmarks::replaceColor Recolors every pixel of every frame, swapping back and forth between two colors
+//!
+void Benchmarks::replaceColor() {
+    QFETCH(int, size);
+    QFETCH(int, frameCount);
+
+    FrameStore frames(size);
+    for (int i = 0; i < frameCount; i++)
+        frames.addFrame();
+    Pixel colors[2] = { 0, packPixel(0, 255, 0, 255) };
+    int pass = 0;
+
+    QCOMPARE(PixelKernels::replaceColor(frames.bits(0), frames.frameBytes() / sizeof(Pixel), colors[0], colors[1]), qsizetype(size) * size);
+    PixelKernels::replaceColor(frames.bits(0), frames.frameBytes() / sizeof(Pixel), colors[1], colors[0]);
+
+    QBENCHMARK {
+        Pixel target = colors[pass % 2];
+        Pixel replacement = colors[++pass % 2];
+        for (int frame = 0; frame < frameCount; frame++)
+            PixelKernels::replaceColor(frames.bits(frame), frames.frameBytes() / sizeof(Pixel), target, replacement);
+    }
+}
+
+void Benchmarks::upscale_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("damage");
+    for (int size = 16; size <= 256; size *= 2) {
+        QTest::newRow(qPrintable(QString("%1x%1 whole frame").arg(size))) << size << size;
+        QTest::newRow(qPrintable(QString("%1x%1 one pixel").arg(size))) << size << 1;
+    }
+}
+
+//!
+//! \brief Benchmarks::upscale Scales a frame, or one damaged pixel of it, up to the 512x512 view
+//!
+void Benchmarks::upscale() {
+    QFETCH(int, size);
+    QFETCH(int, damage);
+
+    const int viewSize = 512;
+    int factor = viewSize / size;
+    FrameStore frames(size);
+    int frame = frames.addFrame();
+    frames.setPixel(frame, size - 1, size - 1, packPixel(255, 0, 0, 255));
+    vector<Pixel> scaled(viewSize * viewSize);
+
+    // The bottom right corner of the view comes from the last source pixel
+    PixelKernels::upscale(frames.constBits(frame), size, QRect(0, 0, size, size), factor, scaled.data(), viewSize);
+    QCOMPARE(scaled.back(), packPixel(255, 0, 0, 255));
+    QCOMPARE(scaled[viewSize * (viewSize - factor) - 1], Pixel(0));
+
+    QRect rect(size - damage, size - damage, damage, damage);
+    QBENCHMARK {
+        PixelKernels::upscale(frames.constBits(frame), size, rect, factor, scaled.data(), viewSize);
+    }
+}
+
+void Benchmarks::loadFile_data() {
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<int>("frameCount");
+    QTest::addColumn<bool>("decodeAll");
+    for (bool decodeAll : { false, true }) {
+        QString mode = decodeAll ? " full decode" : "";
+        QTest::newRow(qPrintable("snowflake.ssp" + mode)) << QString(SNOWFLAKE_PATH) << -1 << decodeAll;
+        for (int size = 16; size <= 256; size *= 2) {
+            for (int frameCount : { 1, 8 }) {
+                for (QString suffix : { "ssp", "sspb" })
+                    QTest::newRow(qPrintable(QString("%1x%1 %2 frames .%3").arg(size).arg(frameCount).arg(suffix) + mode)) << projectPath(size, frameCount, suffix) << frameCount << decodeAll;
+            }
+        }
+    }
+}
+
+//!
+//! \brief Benchmarks::loadFile Opens a project through the model, as the Open action does, waiting for the
+//!        background job to finish. Opening only decodes the first frame, so the full decode rows go on to decode
+//!        every frame as well, which is what drawing on or saving the whole sprite costs.
+//!
+void Benchmarks::loadFile() {
+    QFETCH(QString, path);
+    QFETCH(int, frameCount);
+    QFETCH(bool, decodeAll);
+
+    Model model;
+    QSignalSpy loaded(&model, &Model::loadFrame);
+    model.loadFile(path);
+    model.waitForFileJob();
+    QCOMPARE(loaded.count(), 1);
+    if (frameCount > 0) QCOMPARE(model.frames.frameCount(), frameCount);
+    if (decodeAll) {
+        // Every frame decodes to the same pixels an eager load gives
+        FrameStore eager;
+        QVERIFY(ProjectFile::load(path, eager));
+        QVERIFY(ProjectFile::decodeAll(model.frames, QThreadPool::globalInstance()));
+        for (int i = 0; i < eager.frameCount(); i++)
+            QVERIFY(std::memcmp(model.frames.constBits(i), eager.constBits(i), eager.frameBytes()) == 0);
+    }
+
+    QBENCHMARK {
+        model.loadFile(path);
+        model.waitForFileJob();
+        if (decodeAll)
+            ProjectFile::decodeAll(model.frames, QThreadPool::globalInstance());
+    }
+}
+
+void Benchmarks::saveFile_data() {
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<QString>("suffix");
+    QTest::newRow("snowflake.ssp .ssp") << QString(SNOWFLAKE_PATH) << "ssp";
+    QTest::newRow("snowflake.ssp .sspb") << QString(SNOWFLAKE_PATH) << "sspb";
+    for (int size = 16; size <= 256; size *= 2) {
+        for (int frameCount : { 1, 8 }) {
+            for (QString suffix : { "ssp", "sspb" })
+                QTest::newRow(qPrintable(QString("%1x%1 %2 frames .%3").arg(size).arg(frameCount).arg(suffix))) << projectPath(size, frameCount, "sspb") << suffix;
+        }
+    }
+}
+
+//!
+//! \brief Benchmarks::saveFile Saves a project through the model, as the Save action does, waiting for the
+//!        background job to finish
+//!
+void Benchmarks::saveFile() {
+    QFETCH(QString, path);
+    QFETCH(QString, suffix);
+
+    Model model;
+    model.loadFile(path);
+    model.waitForFileJob();
+    QString saved = projects.filePath("saved." + suffix);
+
+    QBENCHMARK {
+        model.saveFile(saved);
+        model.waitForFileJob();
+    }
+
+    // What was saved opens again
+    FrameStore reloaded;
+    QVERIFY(ProjectFile::load(saved, reloaded));
+    QCOMPARE(reloaded.frameCount(), model.frames.frameCount());
+}
+
+void Benchmarks::autosaveCheckpoint_data() {
+    addCanvasSizeRows();
+}
+
+//!
+//! \brief Benchmarks::autosaveCheckpoint Checkpoints 64 frames into an autosave journal after drawing on one of them,
+//!        including the snapshot the model takes on the GUI thread, then checks the journal recovers the frames
+//!
+void Benchmarks::autosaveCheckpoint() {
+    QFETCH(int, size);
+
+    FrameStore frames(size);
+    for (int i = 0; i < 64; i++)
+        frames.addFrame();
+    fillPattern(frames);
+
+    AutosaveJournal journal(projects.filePath("autosave.sspj"));
+    QVERIFY(journal.checkpoint(*frames.snapshot()));
+    int pass = 0;
+
+    QBENCHMARK {
+        frames.setPixel(pass % frames.frameCount(), 0, 0, packPixel(pass & 0xff, 0, 0, 255));
+        pass++;
+        QVERIFY(journal.checkpoint(*frames.snapshot()));
+    }
+
+    FrameStore recovered;
+    QVERIFY(AutosaveJournal::recover(journal.fileName(), recovered));
+    QCOMPARE(recovered.frameCount(), frames.frameCount());
+    for (int i = 0; i < frames.frameCount(); i++)
+        QVERIFY(std::memcmp(recovered.constBits(i), frames.constBits(i), frames.frameBytes()) == 0);
+    journal.remove();
+}
+
+void Benchmarks::fillDriver_data() {
+    addCanvasSizeRows();
+}
+
+//!
+//! \brief Benchmarks::fillDriver Fills the whole canvas with the fill tool, alternating colors, including recording
+//!        undo and repainting
+//!
+void Benchmarks::fillDriver() {
+    QFETCH(int, size);
+
+    Model model;
+    FrameEditor editor;
+    editor.startNewProject(QString("%1 x %1").arg(size), &model);
+    QColor colors[2] = { Qt::red, Qt::blue };
+    int pass = 0;
+
+    QBENCHMARK {
+        editor.setColor(colors[pass++ % 2]);
+        editor.fillDriver(QPointF(size / 2, size / 2));
+        QCoreApplication::processEvents();
+    }
+    QCOMPARE(model.frames.pixel(0, 0, 0), FrameStore::fromColor(colors[(pass - 1) % 2]));
+}
+
+void Benchmarks::fillAllDriver_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("allFrames");
+    QTest::addColumn<bool>("sparse");
+    for (int size = 16; size <= 256; size *= 2) {
+        QTest::newRow(qPrintable(QString("%1x%1").arg(size))) << size << false << false;
+        QTest::newRow(qPrintable(QString("%1x%1 24 frames").arg(size))) << size << true << false;
+        QTest::newRow(qPrintable(QString("%1x%1 24 frames, color in one").arg(size))) << size << true << true;
+    }
+}
+
+//!
+//! \brief Benchmarks::fillAllDriver Recolors the canvas, or every frame of an animation, with the Fill All tool. The
+//!        sparse rows only have the color in the first frame, so every other frame should be searched but left alone.
+//!
+void Benchmarks::fillAllDriver() {
+    QFETCH(int, size);
+    QFETCH(bool, allFrames);
+    QFETCH(bool, sparse);
+
+    Model model;
+    FrameEditor editor;
+    editor.startNewProject(QString("%1 x %1").arg(size), &model);
+    if (allFrames) {
+        for (int i = 1; i < 24; i++)
+            editor.newFrame(&model);
+    }
+
+    // Start from a solid color, then swap it back and forth with another
+    QColor colors[2] = { Qt::green, Qt::blue };
+    editor.setFillAllFrames(allFrames && !sparse);
+    editor.setColor(colors[0]);
+    editor.fillAllDriver(Qt::transparent);
+    editor.setFillAllFrames(allFrames);
+    vector<quint64> versions(model.frames.frameCount());
+    for (int i = 0; i < model.frames.frameCount(); i++)
+        versions[i] = model.frames.version(i);
+    int pass = 0;
+
+    QBENCHMARK {
+        editor.setColor(colors[(pass + 1) % 2]);
+        editor.fillAllDriver(colors[pass % 2]);
+        pass++;
+        QCoreApplication::processEvents();
+    }
+
+    // Frames without the color were never written to
+    QCOMPARE(model.frames.pixel(0, 0, 0), FrameStore::fromColor(colors[pass % 2]));
+    for (int i = 1; sparse && i < model.frames.frameCount(); i++)
+        QCOMPARE(model.frames.version(i), versions[i]);
+}
+
+void Benchmarks::drawStamp_data() {
+    addCanvasSizeRows();
+}
+
+//!
+//! \brief Benchmarks::drawStamp Stamps a circle a quarter of the canvas across in the middle of the canvas
+//!
+void Benchmarks::drawStamp() {
+    QFETCH(int, size);
+
+    Model model;
+    FrameEditor editor;
+    editor.startNewProject(QString("%1 x %1").arg(size), &model);
+    const Stamp &circle = editor.stamp(Stamp::Circle, size / 8, size / 8);
+    Pixel pixel = packPixel(0, 0, 255, 255);
+
+    QBENCHMARK {
+        editor.drawStamp(circle, QPointF(size / 2, size / 2), pixel);
+        editor.finishStroke();
+        QCoreApplication::processEvents();
+    }
+}
+
+void Benchmarks::drawSegment_data() {
+    addCanvasSizeRows();
+}
+
+//!
+//! \brief Benchmarks::drawSegment Draws a mirrored brush stroke as a 1000 Hz mouse would send it, one short segment
+//!        per sample, corner to corner and back
+//!
+void Benchmarks::drawSegment() {
+    QFETCH(int, size);
+
+    Model model;
+    FrameEditor editor;
+    editor.startNewProject(QString("%1 x %1").arg(size), &model);
+    editor.activeMirror(true);
+    Pixel pixel = packPixel(255, 0, 0, 255);
+    const int samples = 1000;
+
+    QBENCHMARK {
+        QPointF last(0, 0);
+        for (int sample = 1; sample <= samples; sample++) {
+            qreal t = qreal(sample % (samples / 2)) / (samples / 2);
+            QPointF point = sample < samples / 2 ? QPointF(t, t) * (size - 1) : QPointF(1 - t, t) * (size - 1);
+            editor.drawSegment(last, point, pixel);
+            last = point;
+        }
+        editor.finishStroke();
+        QCoreApplication::processEvents();
+    }
+}
+
+void Benchmarks::flushDamage_data() {
+    addCanvasSizeRows();
+}
+
+//!
+//! \brief Benchmarks::flushDamage Redraws the whole frame into the 512x512 view, which replaced scaledMap
+//!
+void Benchmarks::flushDamage() {
+    QFETCH(int, size);
+
+    Model model;
+    FrameEditor editor;
+    editor.startNewProject(QString("%1 x %1").arg(size), &model);
+    fillPattern(model.frames);
+
+    QBENCHMARK {
+        editor.repaintFrame();
+        QCoreApplication::processEvents();
+    }
+}
+
+void Benchmarks::previewFrame_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("edited");
+    for (int size = 16; size <= 256; size *= 2) {
+        QTest::newRow(qPrintable(QString("%1x%1 cached").arg(size))) << size << false;
+        QTest::newRow(qPrintable(QString("%1x%1 edited").arg(size))) << size << true;
+    }
+}
+
+//!
+//! \brief Benchmarks::previewFrame Hands each frame of a 24 frame animation to the preview, scaled up to the preview's
+//!        256x256 label, either straight from the cache or after every frame was drawn on
+//!
+void Benchmarks::previewFrame() {
+    QFETCH(int, size);
+    QFETCH(bool, edited);
+
+    const int frameCount = 24;
+    FrameStore frames(size);
+    for (int i = 0; i < frameCount; i++)
+        frames.addFrame();
+    fillPattern(frames);
+
+    PreviewCache cache;
+    cache.setScale(QSize(256, 256), true);
+    QLabel label;
+    int tick = 0;
+
+    QBENCHMARK {
+        int frame = tick++ % frameCount;
+        if (edited) frames.setPixel(frame, 0, 0, packPixel(tick & 0xff, 0, 0, 255));
+        label.setPixmap(cache.frame(frames, frame));
+    }
+}
+
+//!
+//! \brief takeOption Removes an option and its value from the arguments
+//! \return The value, or an empty string if the option is not there
+//!
+static QString takeOption(QStringList &arguments, const QString &name) {
+    int index = arguments.indexOf(name);
+    if (index < 0 || index + 1 >= arguments.size())
+        return QString();
+
+    QString value = arguments[index + 1];
+    arguments.remove(index, 2);
+    return value;
+}
+
+//!
+//! \brief readResults Collects every benchmark result from QtTest's XML log
+//! \param filename The log
+//! \return "function/tag" mapped to the metric and the time per iteration
+//!
+static QJsonObject readResults(const QString &filename) {
+    QFile file(filename);
+    QJsonObject results;
+    if (!file.open(QIODevice::ReadOnly))
+        return results;
+
+    QXmlStreamReader xml(&file);
+    QString function;
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        if (xml.name() == QLatin1String("TestFunction")) {
+            function = xml.attributes().value("name").toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            QXmlStreamAttributes attributes = xml.attributes();
+            QJsonObject result;
+            result["metric"] = attributes.value("metric").toString();
+            result["value"] = attributes.value("value").toDouble();
+            result["iterations"] = attributes.value("iterations").toInt();
+            results[function + "/" + attributes.value("tag").toString()] = result;
+        }
+    }
+    return results;
+}
+
+//!
+//! \brief compareResults Prints every benchmark that got slower than the baseline by more than the threshold
+//! \param results This run's results
+//! \param baseline The stored results to compare against
+//! \param threshold How much slower, in percent, counts as a regression
+//! \return The number of regressions
+//!
+static int compareResults(const QJsonObject &results, const QJsonObject &baseline, double threshold) {
+    int regressions = 0;
+    int compared = 0;
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        QJsonObject now = it.value().toObject();
+        QJsonObject before = baseline.value(it.key()).toObject();
+        if (before.isEmpty() || before["metric"] != now["metric"] || before["value"].toDouble() <= 0)
+            continue;
+
+        compared++;
+        double change = (now["value"].toDouble() / before["value"].toDouble() - 1) * 100;
+        if (change > threshold) {
+            regressions++;
+            qWarning("REGRESSION %s: %g -> %g %s (%+.1f%%)", qPrintable(it.key()), before["value"].toDouble(),
+                     now["value"].toDouble(), qPrintable(now["metric"].toString()), change);
+        }
+    }
+    qInfo("Compared %d benchmarks against the baseline, %d regressed by more than %g%%", compared, regressions, threshold);
+    return regressions;
+}
+
+//!
+//! \brief main Runs the benchmarks. As well as every QtTest option it takes:
+//!        -json <file>        write the results as JSON, "function/tag": { metric, value, iterations }
+//!        -baseline <file>    compare against results written by -json, failing if any regressed
+//!        -threshold <pct>    how much slower counts as a regression, 10% by default
+//!        The tools need a QApplication, so run with QT_QPA_PLATFORM=offscreen where there is no display.
+//!
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    QStringList arguments = app.arguments();
+    QString jsonPath = takeOption(arguments, "-json");
+    QString baselinePath = takeOption(arguments, "-baseline");
+    QString threshold = takeOption(arguments, "-threshold");
+
+    Benchmarks benchmarks;
+    if (jsonPath.isEmpty() && baselinePath.isEmpty())
+        return QTest::qExec(&benchmarks, arguments);
+
+    // Log to the console as usual and to XML to collect the results from
+    QTemporaryDir logDir;
+    QString log = logDir.filePath("results.xml");
+    arguments << "-o" << "-,txt" << "-o" << log + ",xml";
+    int status = QTest::qExec(&benchmarks, arguments);
+    QJsonObject results = readResults(log);
+
+    if (!jsonPath.isEmpty()) {
+        QFile file(jsonPath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(results).toJson()) < 0) {
+            qWarning("Unable to write %s", qPrintable(jsonPath));
+            return 1;
+        }
+    }
+
+    if (!baselinePath.isEmpty()) {
+        QFile file(baselinePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning("Unable to read %s", qPrintable(baselinePath));
+            return 1;
+        }
+        QJsonObject baseline = QJsonDocument::fromJson(file.readAll()).object();
+        if (compareResults(results, baseline, threshold.isEmpty() ? 10 : threshold.toDouble()) > 0)
+            status = status ? status : 1;
+    }
+    return status;
+}
+
+#include "tst_benchmarks.moc"
@@ -0,0 +1,38 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "canvasitem.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+//!
+//! \brief CanvasItem::CanvasItem Constructor
+//! \param image The scaled frame to show, owned by the caller
+//! \param parent The parent item
+//!
+CanvasItem::CanvasItem(const QImage *image, QGraphicsItem *parent) : QGraphicsItem(parent), image(image) {
+    // Ask for the exposed rectangle so paint only draws what changed
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+//!
+//! \brief CanvasItem::boundingRect The area the scaled frame covers
+//! \return The rectangle
+//!
+QRectF CanvasItem::boundingRect() const {
+    return QRectF(image->rect());
+}
+
+//!
+//! \brief CanvasItem::paint Draws the exposed part of the scaled frame
+//! \param painter The painter to draw with
+//! \param option Holds the exposed rectangle
+//! \param widget Unused
+//!
+void CanvasItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(widget);
+    QRectF exposed = option->exposedRect.intersected(boundingRect());
+    painter->drawImage(exposed, *image, exposed);
+}
@@ -0,0 +1,28 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef CANVASITEM_H
+#define CANVASITEM_H
+
+#include <QGraphicsItem>
+#include <QImage>
+
+//!
+//! \brief CanvasItem Shows the editor's scaled frame buffer in the scene. It paints straight from the buffer, so only
+//!        the exposed part is drawn and damaged areas can be repainted with update(rect) instead of a new pixmap.
+//!
+class CanvasItem : public QGraphicsItem
+{
+public:
+    explicit CanvasItem(const QImage *image, QGraphicsItem *parent = nullptr);
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+private:
+    const QImage *image;
+};
+
+#endif // CANVASITEM_H
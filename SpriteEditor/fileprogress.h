@@ -0,0 +1,35 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef FILEPROGRESS_H
+#define FILEPROGRESS_H
+
+#include <atomic>
+
+//!
+//! \brief FileProgress How many frames a load or save has got through, and whether it has been asked to stop. The job
+//!        advances it from whichever threads do the work while another thread reads it and can cancel, so everything
+//!        is atomic. A total of 0 means the number of frames is not known yet.
+//!
+class FileProgress
+{
+public:
+    void start(int total) { doneCount = 0; totalCount = total; }
+    void setTotal(int total) { totalCount = total; }
+    void advance(int count = 1) { doneCount += count; }
+    void cancel() { cancelled = true; }
+    void reset() { doneCount = 0; totalCount = 0; cancelled = false; }
+
+    int done() const { return doneCount; }
+    int total() const { return totalCount; }
+    bool isCancelled() const { return cancelled; }
+
+private:
+    std::atomic<int> doneCount { 0 };
+    std::atomic<int> totalCount { 0 };
+    std::atomic<bool> cancelled { false };
+};
+
+#endif // FILEPROGRESS_H
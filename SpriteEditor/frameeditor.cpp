@@ -6,7 +6,13 @@
  */
 
 #include "frameeditor.h"
+#include "framepool.h"
 #include "qgraphicssceneevent.h"
+#include "trace.h"
+#include <QtConcurrent>
+
+// The width and height of the canvas on screen, every frame is scaled up to fill it
+static const int viewSize = 512;
 
 //!
 //! \brief FrameEditor::FrameEditor Sets up the UI and the default instance variables
@@ -14,46 +20,58 @@
 //!
 FrameEditor::FrameEditor(QWidget *parent) : QWidget(parent), ui(new Ui::frameEditor) {
     ui->setupUi(this);
-    QCoreApplication::instance()->installEventFilter(this);
+    // Only the canvas's mouse events are needed, everything else in the application goes straight past
+    ui->graphicsView->viewport()->installEventFilter(this);
 
     // Set up the default color, frame size and selected tool.
     currentColor = Qt::black;
     sizeValue = 32;
     selectedTool = "brush";
     mirror = false;
+    fillDiagonal = false;
+    fillTolerance = 0;
+    brushRadius = 0;
+    fillAllFrames = false;
+    frames = nullptr;
+    currentFrame = 0;
+    repaintPending = false;
+    strokeRecording = false;
+    strokePending = false;
+
+    gridTileSize = 0;
+
+    // The frame is scaled into this buffer, which the canvas item draws from
+    scaledFrame = QImage(viewSize, viewSize, QImage::Format_RGBA8888);
+    scaledFrame.fill(Qt::transparent);
+
+    // One scene and one canvas item show whichever frame is current, for the life of the editor
+    scene = new QGraphicsScene(this);
+    ui->graphicsView->resize(viewSize, viewSize);
+    ui->graphicsView->setSceneRect(0, 0, viewSize, viewSize);
+    ui->graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    ui->graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    ui->graphicsView->setScene(scene);
+    scene->setSceneRect(ui->graphicsView->rect());
+
+    currentItem = new CanvasItem(&scaledFrame);
+    scene->addItem(currentItem);
 }
 
 //!
-//! \brief FrameEditor::setupNewFrame Handles resetting all the curent objects, updating the UI, and updating the object vectors
+//! \brief FrameEditor::setupNewFrame Adds a frame to the model and shows it on the canvas
 //! \param size The size of the new frame
-//! \param model The model object so the objects can be added to the models vectors
+//! \param model The model object so the frame can be added to its frame store
 //!
 void FrameEditor::setupNewFrame(int size, Model* model) {
-    // Set up how the frame looks on screen for the user
-    scene = new QGraphicsScene;
-    ui->graphicsView->resize(512, 512);
-    ui->graphicsView->setSceneRect(0, 0, 512, 512);
-    ui->graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    ui->graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    ui->graphicsView->setScene(scene);
-
+    // Make sure the grid tile background matches the frame size
     updateGridTile(size);
 
-    scene->setSceneRect(ui->graphicsView->rect());
-
-    // Initializes the current map and adds it to the map vector
-    currentMap = new QPixmap(sizeValue, sizeValue);
-    currentMap->fill(Qt::transparent);
-    model->maps.push_back(currentMap);
+    // Adds a transparent frame to the frame store and makes it the current frame
+    frames = &model->frames;
+    currentFrame = frames->addFrame();
 
-    // Initializes the current painter and adds it to the painter vector
-    currentPainter = new QPainter(currentMap);
-    model->painters.push_back(currentPainter);
-
-    // Initializes the current item and adds it to the item vector
-    currentItem = new QGraphicsPixmapItem(scaledMap());
-    scene->addItem(currentItem);
-    model->items.push_back(currentItem);
+    // The canvas item is reused, only its buffer is redrawn
+    repaintFrame();
 }
 
 //!
@@ -61,25 +79,46 @@ void FrameEditor::setupNewFrame(int size, Model* model) {
 //! \param model The model object to get the number of frames from
 //!
 void FrameEditor::newFrame(Model* model) {
+    history.beginOperation();
     setupNewFrame(sizeValue, model);
-    emit changeFrameNumber(model->maps.size());
+    history.recordInsertFrame(currentFrame);
+    endHistoryOperation();
+    emit changeFrameNumber(model->frames.frameCount());
 }
 
 //!
-//! \brief FrameEditor::deleteCurrentFrame Deletes the current frame from the model and all objects associated with it
-//! \param model The model to delete the objects from
+//! \brief FrameEditor::deleteCurrentFrame Deletes the current frame from the model
+//! \param model The model to delete the frame from
 //!
 void FrameEditor::deleteCurrentFrame(Model* model) {
-    int frameIndex = std::find(model->maps.begin(), model->maps.end(), currentMap) - model->maps.begin();
+    int frameIndex = currentFrame;
 
-    // Delete the frame from the backing vector, painter, and items
-    model->maps.erase(model->maps.begin() + frameIndex);
-    model->items.erase(model->items.begin() + frameIndex);
-    model->painters.erase(model->painters.begin() + frameIndex);
+    // Delete the frame's pixels from the frame store, keeping a copy so it can be undone
+    history.beginOperation();
+    history.recordRemoveFrame(model->frames, frameIndex);
+    model->frames.removeFrame(frameIndex);
 
     // If there are still existing frames change to the next one else add a new default frame
-    if(model->maps.size() > 0) changeCurrentFrame(frameIndex + 1, model);
+    if(model->frames.frameCount() > 0) changeCurrentFrame(frameIndex + 1, model);
     else newFrame(model);
+    endHistoryOperation();
+}
+
+//!
+//! \brief FrameEditor::duplicateCurrentFrame Inserts a copy of the current frame after it and switches to the copy.
+//!        The copy shares the frame's pixels until one of them is drawn on.
+//! \param model The model that holds the frames
+//!
+void FrameEditor::duplicateCurrentFrame(Model* model) {
+    frames = &model->frames;
+
+    history.beginOperation();
+    currentFrame = frames->duplicateFrame(currentFrame);
+    history.recordInsertFrame(currentFrame);
+    endHistoryOperation();
+
+    repaintFrame();
+    emit changeFrameNumber(currentFrame + 1);
 }
 
 //!
@@ -88,31 +127,27 @@ void FrameEditor::deleteCurrentFrame(Model* model) {
 //! \param model The model object to update the frame objects in
 //!
 void FrameEditor::changeCurrentFrame(int frameNumber, Model* model) {
-    scene->removeItem(currentItem);
+    frames = &model->frames;
 
     // Checks that the chosen frame is an existing frame.
-    if((int) model->maps.size() > frameNumber - 1) {
-        sizeValue = model->size;
-        currentMap = model->maps[frameNumber - 1];
+    if(frames->frameCount() > frameNumber - 1) {
+        sizeValue = frames->size();
+        currentFrame = frameNumber - 1;
 
         // Make sure the grid tile background is scaled
         updateGridTile(sizeValue);
 
-        // Make sure the pixmap is scaled
-        model->items[frameNumber - 1]->setPixmap(scaledMap());
-        currentItem = model->items[frameNumber - 1];
-        currentPainter = model->painters[frameNumber - 1];
-        scene->addItem(currentItem);
+        // Make sure the new frame is drawn
+        repaintFrame();
 
         emit changeFrameNumber(frameNumber);
     }
     // The user tried to change the frame to a non-existent frame so display the last frame
     else {
-        currentItem = model->items[model->items.size() - 1];
-        currentMap = model->maps[model->maps.size() - 1];
-        currentPainter = model->painters[frameNumber - 1];
+        currentFrame = frames->frameCount() - 1;
+        repaintFrame();
 
-        emit changeFrameNumber(model->maps.size());
+        emit changeFrameNumber(frames->frameCount());
     }
 }
 
@@ -125,12 +160,15 @@ void FrameEditor::startNewProject(QString size, Model* model) {
     // Parses the QString into an int size value
     sizeValue = size.mid(0, size.indexOf(" ")).toInt();
 
-    // Starts a new project by clearing backing items, maps, painter, and resetting size
-    model->items.clear();
-    model->maps.clear();
-    model->painters.clear();
-    model->size = sizeValue;
+    // Starts a new project by clearing the frame store and resetting size
+    int oldSize = model->frames.size();
+    model->frames.reset(sizeValue);
     setupNewFrame(sizeValue, model);
+    clearHistory();
+
+    // Pooled blocks of the old canvas size are no use to the new one
+    if (sizeValue != oldSize)
+        FramePool::trim();
 
     emit changeFrameNumber(1);
 }
@@ -160,235 +198,499 @@ void FrameEditor::activeMirror(bool active) {
 }
 
 //!
-//! \brief FrameEditor::eventFilter Handles all mouseevents on the frame editor
+//! \brief FrameEditor::setFillDiagonal Sets whether the fill tool also spreads to diagonal neighbours
+//! \param diagonal Whether to use 8-way connectivity
+//!
+void FrameEditor::setFillDiagonal(bool diagonal) {
+    fillDiagonal = diagonal;
+}
+
+//!
+//! \brief FrameEditor::setFillTolerance Sets how different a color can be from the clicked color and still be filled
+//! \param tolerance The largest per-channel difference, from 0 to 255
+//!
+void FrameEditor::setFillTolerance(int tolerance) {
+    fillTolerance = qBound(0, tolerance, 255);
+}
+
+//!
+//! \brief FrameEditor::setBrushRadius Sets how thick the brush and eraser draw
+//! \param radius How many pixels the brush reaches around its center, 0 for one pixel
+//!
+void FrameEditor::setBrushRadius(int radius) {
+    brushRadius = qBound(0, radius, 64);
+}
+
+//!
+//! \brief FrameEditor::currentBrushRadius Gets how thick the brush and eraser draw
+//! \return How many pixels the brush reaches around its center
+//!
+int FrameEditor::currentBrushRadius() const {
+    return brushRadius;
+}
+
+//!
+//! \brief FrameEditor::setFillAllFrames Sets whether Fill All recolors every frame instead of only the current one
+//! \param allFrames Whether to recolor every frame
+//!
+void FrameEditor::setFillAllFrames(bool allFrames) {
+    fillAllFrames = allFrames;
+}
+
+//!
+//! \brief FrameEditor::currentFillTolerance Gets the fill tool's color tolerance
+//! \return The largest per-channel difference that is filled
+//!
+int FrameEditor::currentFillTolerance() const {
+    return fillTolerance;
+}
+
+//!
+//! \brief FrameEditor::undo Reverses the most recent tool operation and shows the frame it changed
+//!
+void FrameEditor::undo() {
+    finishStroke();
+    showHistoryFrame(history.undo(*frames));
+}
+
+//!
+//! \brief FrameEditor::redo Repeats the most recently undone tool operation and shows the frame it changed
+//!
+void FrameEditor::redo() {
+    finishStroke();
+    showHistoryFrame(history.redo(*frames));
+}
+
+//!
+//! \brief FrameEditor::clearHistory Forgets every operation, for when the frames are replaced by a new or loaded project
+//!
+void FrameEditor::clearHistory() {
+    strokeRecording = false;
+    history.clear();
+    emit historyChanged(false, false);
+}
+
+//!
+//! \brief FrameEditor::unmapFile Copies the frames, and the removed frames kept for undo, that are mapped from a file
+//!        about to be saved over, so nothing keeps the file open while it is replaced
+//! \param filename The file about to be saved (includes path)
+//!
+void FrameEditor::unmapFile(const QString &filename) {
+    frames->unmapFile(filename);
+    history.unmapFile(*frames, filename);
+}
+
+//!
+//! \brief FrameEditor::setUndoMemoryLimit Sets how much memory the undo history may use before the oldest operations
+//!        are forgotten
+//! \param megabytes The limit in megabytes
+//!
+void FrameEditor::setUndoMemoryLimit(int megabytes) {
+    history.setMemoryBudget(qsizetype(megabytes) * 1024 * 1024);
+    emit historyChanged(history.canUndo(), history.canRedo());
+}
+
+//!
+//! \brief FrameEditor::undoMemoryLimit Gets how much memory the undo history may use
+//! \return The limit in megabytes
+//!
+int FrameEditor::undoMemoryLimit() const {
+    return int(history.memoryBudget() / (1024 * 1024));
+}
+
+//!
+//! \brief FrameEditor::eventFilter Handles the mouse events on the canvas. Only the canvas's viewport is filtered, so
+//!        the rest of the application's events never come through here.
 //! \param obj Object that activated event
 //! \param event Type of mouse event
 //! \return boolean If mouse is moving return true
 //!
 bool FrameEditor::eventFilter(QObject *obj, QEvent *event) {
-    QPointF point = this->mapFromGlobal(QCursor::pos());
-
-    // Convert from 512 by 512 to user-sepecified/default QPixmap size
-    QPointF scaledPoint(point.x() * sizeValue / 512, point.y() * sizeValue / 512);
-
-    // If the point is not in the frame editor, ignore the mouse event
-    if (scaledPoint.x() < 0 || scaledPoint.y() < 0 || scaledPoint.x() > sizeValue || scaledPoint.y() > sizeValue) {
+    if(obj != ui->graphicsView->viewport()) return false;
+
+    switch(event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseMove:
+    case QEvent::MouseButtonRelease:
+        break;
+    default:
         return false;
     }
 
-    // Mouse is pressed and is not being held
-    if(event->type() == QGraphicsSceneMouseEvent::MouseButtonPress && !mouseHeld){
-        handlePaintAction(scaledPoint);
-    }
+    TraceScope trace("FrameEditor::eventFilter");
+    QMouseEvent* mouseEvent = static_cast<QMouseEvent *>(event);
+    QPointF scaledPoint = toFramePoint(mouseEvent->position());
 
-    // When mouse is moving, draw over all
-    if(event->type() == QGraphicsSceneMouseEvent::MouseMove){
+    // When mouse is moving, only the newest position is kept until the stroke catches up with it
+    if(event->type() == QEvent::MouseMove){
         if(mouseHeld) {
-            lastPoint = &point;
-            handlePaintAction(scaledPoint);
+            pendingPoint = scaledPoint;
+            if(!strokePending) {
+                strokePending = true;
+                QTimer::singleShot(0, this, &FrameEditor::flushStroke);
+            }
         }
         return true;
 
-    // Mouse is first pressed and held event becomes true
-    } else if(event->type() == QEvent::MouseButtonPress){
-        QMouseEvent* mouseEvent = static_cast<QMouseEvent *>(event);
-        if(mouseEvent->button() == Qt::LeftButton)
-            mouseHeld = true;
-
-    // If mouse is released, held is set to false
+    // If mouse is released, the rest of the stroke is drawn and held is set to false
     } else if(event->type() == QEvent::MouseButtonRelease){
-        QMouseEvent* mouseEvent = static_cast<QMouseEvent *>(event);
+        flushStroke();
         if(mouseEvent->button() == Qt::LeftButton)
             mouseHeld = false;
+        finishStroke();
+        return false;
+    }
+
+    // If the point is not in the frame, ignore the press
+    if (scaledPoint.x() < 0 || scaledPoint.y() < 0 || scaledPoint.x() > sizeValue || scaledPoint.y() > sizeValue) {
+        return false;
+    }
+
+    // Mouse is pressed and is not being held
+    if(!mouseHeld){
+        handlePaintAction(scaledPoint);
+    }
+
+    // Mouse is first pressed and held event becomes true
+    if(mouseEvent->button() == Qt::LeftButton) {
+        mouseHeld = true;
+        lastPoint = scaledPoint;
     }
 
     return false;
 }
 
+//!
+//! \brief FrameEditor::toFramePoint Converts a position on the canvas's viewport to frame coordinates
+//! \param position The position in the viewport
+//! \return The position in the frame, which may be outside it
+//!
+QPointF FrameEditor::toFramePoint(QPointF position) const {
+    QPointF point = ui->graphicsView->mapToScene(position.toPoint());
+    return QPointF(point.x() * sizeValue / viewSize, point.y() * sizeValue / viewSize);
+}
+
+//!
+//! \brief FrameEditor::flushStroke Continues the stroke being drawn to the newest mouse position. However many moves
+//!        arrived since the last event loop pass, they become one segment from where the stroke last was.
+//!
+void FrameEditor::flushStroke() {
+    if(!strokePending) return;
+    strokePending = false;
+    if(!mouseHeld) return;
+
+    QPointF point = pendingPoint;
+    if(selectedTool == "brush") {
+        // A line from where the stroke was, so fast strokes do not leave gaps
+        drawSegment(lastPoint, point, FrameStore::fromColor(currentColor));
+    } else if(selectedTool == "erasor") {
+        drawSegment(lastPoint, point, 0);
+    } else {
+        // Shapes are stamped where the mouse is
+        handlePaintAction(point);
+    }
+    lastPoint = point;
+}
+
 //!
 //! \brief FrameEditor::handlePaintAction Handles all tool painting
 //! \param scaledPoint Point at which to paint on the frame editor
 //!
 void FrameEditor::handlePaintAction(QPointF scaledPoint) {
+    TraceScope trace("FrameEditor::handlePaintAction");
     int sizeScalar = sizeValue / 16;
-    QPointF inversePoint(sizeValue - scaledPoint.x(), scaledPoint.y());
 
     if(selectedTool == "brush") {
-        // Draws on the scaledPoint pixel, if mirrored, draws on the inverse pixel as well
-        if(mirror){
-            fillPixel(currentColor, scaledPoint);
-            fillPixel(currentColor, inversePoint);
-        } else {
-            fillPixel(currentColor, scaledPoint);
-        }
+        // Draws the scaledPoint pixel as a one pixel segment, whose span is reflected as a whole if mirrored
+        drawSegment(scaledPoint, scaledPoint, FrameStore::fromColor(currentColor));
     } else if(selectedTool == "erasor") {
-        // Erases on the scaledPoint pixel, if mirrored, erases on the inverse pixel as well
-        if(mirror) {
-            fillPixel(Qt::transparent, scaledPoint);
-            fillPixel(Qt::transparent, inversePoint);
-        } else {
-            fillPixel(Qt::transparent, scaledPoint);
-        }
+        // Erases the scaledPoint pixel as a one pixel segment, whose span is reflected as a whole if mirrored
+        drawSegment(scaledPoint, scaledPoint, 0);
     } else if(selectedTool == "fill" && !mouseHeld) {
-        // Gets the color to fill, and calls recursive fill method
-        QColor fillColor = currentMap->toImage().pixelColor(scaledPoint.x(), scaledPoint.y());
-        if(!(fillColor == currentColor)) {
-            fillDriver(fillColor, scaledPoint);
-        }
+        // Fills the region of the clicked color around the point
+        fillDriver(scaledPoint);
     } else if(selectedTool == "fillAll" && !mouseHeld) {
-        // Gets the color to fill, and calls recursive fill all method
-        QColor fillColor = currentMap->toImage().pixelColor(scaledPoint.x(), scaledPoint.y());
+        // Gets the color under the point, and recolors every pixel of it with the replaceColor kernel
+        if(!frames->contains(scaledPoint.x(), scaledPoint.y())) return;
+        QColor fillColor = FrameStore::toColor(frames->pixel(currentFrame, scaledPoint.x(), scaledPoint.y()));
         fillAllDriver(fillColor);
     } else if(selectedTool == "eyedrop" && !mouseHeld) {
         // Gets the color of the pixel, and sets the current color to that color
-        currentColor = QColor(currentMap->toImage().pixel(scaledPoint.x(), scaledPoint.y()));
+        if(!frames->contains(scaledPoint.x(), scaledPoint.y())) return;
+        QColor pixelColor = FrameStore::toColor(frames->pixel(currentFrame, scaledPoint.x(), scaledPoint.y()));
+        currentColor = QColor(pixelColor.red(), pixelColor.green(), pixelColor.blue());
         emit changeCurrentColor(currentColor);
     } else if(selectedTool == "rectangle") {
-        // Draws a rectangle using fillShapeSize method, and if mirrored, and inverse rectangle
-        if(mirror){
-            fillShapeSize(scaledPoint, QSize(2 * sizeScalar, sizeScalar));
-            fillShapeSize(inversePoint, QSize(2 * sizeScalar, sizeScalar));
-        } else {
-            fillShapeSize(scaledPoint, QSize(2 * sizeScalar, sizeScalar));
-        }
+        // Stamps a rectangle twice as wide as it is tall, mirrored if the mirror is on
+        drawStamp(stamp(Stamp::Rectangle, 2 * sizeScalar, sizeScalar), scaledPoint, FrameStore::fromColor(currentColor));
     } else if(selectedTool == "circle") {
-        int sizeOffset = sizeScalar == 1 ? 0 : sizeScalar / 2;
-        int edgesOffset = sizeScalar == 1 ? 1 : sizeScalar;
-
-        if(mirror){
-            // Fills the initial square
-            fillShapeSize(scaledPoint, QSize(2 * edgesOffset, 2 * edgesOffset));
-
-            // Fills the edges of the square to give the circle a "rounded" look
-            fillShapeSize(QPointF(scaledPoint.x() - 3 * edgesOffset + sizeOffset, scaledPoint.y()), QSize(sizeOffset, edgesOffset));
-            fillShapeSize(QPointF(scaledPoint.x() + 3 * edgesOffset - sizeOffset, scaledPoint.y()), QSize(sizeOffset, edgesOffset));
-            fillShapeSize(QPointF(scaledPoint.x(), scaledPoint.y() - 3 * edgesOffset + sizeOffset), QSize(edgesOffset, sizeOffset));
-            fillShapeSize(QPointF(scaledPoint.x(), scaledPoint.y() + 3 * edgesOffset - sizeOffset), QSize(edgesOffset, sizeOffset));
-
-            // Fills the initial square
-            fillShapeSize(inversePoint, QSize(2 * edgesOffset, 2 * edgesOffset));
-
-            // Fills the edges of the square to give the circle a "rounded" look
-            fillShapeSize(QPointF(inversePoint.x() - 3 * edgesOffset + sizeOffset, inversePoint.y()), QSize(sizeOffset, edgesOffset));
-            fillShapeSize(QPointF(inversePoint.x() + 3 * edgesOffset - sizeOffset, inversePoint.y()), QSize(sizeOffset, edgesOffset));
-            fillShapeSize(QPointF(inversePoint.x(), inversePoint.y() - 3 * edgesOffset + sizeOffset), QSize(edgesOffset, sizeOffset));
-            fillShapeSize(QPointF(inversePoint.x(), inversePoint.y() + 3 * edgesOffset - sizeOffset), QSize(edgesOffset, sizeOffset));
-        } else {
-            // Fills the initial square
-            fillShapeSize(scaledPoint, QSize(2 * edgesOffset, 2 * edgesOffset));
-
-            // Fills the edges of the square to give the circle a "rounded" look
-            fillShapeSize(QPointF(scaledPoint.x() - 3 * edgesOffset + sizeOffset, scaledPoint.y()), QSize(sizeOffset, edgesOffset));
-            fillShapeSize(QPointF(scaledPoint.x() + 3 * edgesOffset - sizeOffset, scaledPoint.y()), QSize(sizeOffset, edgesOffset));
-            fillShapeSize(QPointF(scaledPoint.x(), scaledPoint.y() - 3 * edgesOffset + sizeOffset), QSize(edgesOffset, sizeOffset));
-            fillShapeSize(QPointF(scaledPoint.x(), scaledPoint.y() + 3 * edgesOffset - sizeOffset), QSize(edgesOffset, sizeOffset));
-        }
+        int radius = 3 * qMax(1, sizeScalar);
+        drawStamp(stamp(Stamp::Circle, radius, radius), scaledPoint, FrameStore::fromColor(currentColor));
     } else if(selectedTool == "square") {
-        // Draws a square using fillShapeSize, and if mirrored, and inverse square
-        if(mirror){
-            fillShapeSize(scaledPoint, QSize(sizeScalar, sizeScalar));
-            fillShapeSize(inversePoint, QSize(sizeScalar, sizeScalar));
-        } else {
-            fillShapeSize(scaledPoint, QSize(sizeScalar, sizeScalar));
-        }
+        drawStamp(stamp(Stamp::Rectangle, sizeScalar, sizeScalar), scaledPoint, FrameStore::fromColor(currentColor));
     }
 }
 
 //!
-//! \brief FrameEditor::fillDriver Recursive driver method to fill
-//! \param fillColor Color to replace or fill
+//! \brief FrameEditor::fillDriver Fills the region of the color under a point with the current color
 //! \param point Point at which to fill
 //!
-void FrameEditor::fillDriver(QColor fillColor, QPointF point) {
-    // The color at the point you want to fill
-    QColor pixelColor = currentMap->toImage().pixelColor(point.x(), point.y());
-
-    // If the color is the color you want to fill, fills recursively up, right, down, and left
-    if (pixelColor == fillColor) {
-        fillPixel(currentColor, point);
-        QPointF right(point.x() + 1, point.y());
-        QPointF down(point.x(), point.y() - 1);
-        QPointF left(point.x() - 1, point.y());
-        QPointF up(point.x(), point.y() + 1);
-        fillDriver(fillColor, right);
-        fillDriver(fillColor, down);
-        fillDriver(fillColor, left);
-        fillDriver(fillColor, up);
+void FrameEditor::fillDriver(QPointF point) {
+    // Ignore clicks off the edge of the frame
+    if (!frames->contains(point.x(), point.y())) return;
+
+    PixelKernels::FillOptions options;
+    options.diagonal = fillDiagonal;
+    options.tolerance = fillTolerance;
+
+    // The region is found without writing to the frame, so the history can save the tiles under it first
+    Pixel replacement = FrameStore::fromColor(currentColor);
+    int size = frames->size();
+    fillSpans.clear();
+    QRect filled = PixelKernels::floodRegion(frames->constBits(currentFrame), size, QPoint(point.x(), point.y()), replacement, options, fillSpans);
+    if (filled.isEmpty()) return;
+
+    history.beginOperation();
+    history.touch(*frames, currentFrame, filled);
+    Pixel *bits = frames->bits(currentFrame);
+    for (const PixelKernels::Span &span : fillSpans)
+        std::fill_n(bits + qsizetype(span.y) * size + span.left, span.right - span.left + 1, replacement);
+    endHistoryOperation();
+    markDamaged(filled);
+}
+
+//!
+//! \brief FrameEditor::fillAllDriver Fills all instances of a color in the frame, or in every frame, to a new color.
+//!        Every frame is searched for the color first, which only reads it, so frames without the color are neither
+//!        copied nor recorded for undo, and only the rows holding the color are rewritten.
+//! \param fillColor Color to replace old color with
+//!
+void FrameEditor::fillAllDriver(QColor fillColor) {
+    Pixel target = FrameStore::fromColor(fillColor);
+    Pixel replacement = FrameStore::fromColor(currentColor);
+    if (target == replacement) return;
+    int size = frames->size();
+
+    vector<int> candidates;
+    if(fillAllFrames) {
+        for(int frame = 0; frame < frames->frameCount(); frame++)
+            candidates.push_back(frame);
     } else {
-        return;
+        candidates.push_back(currentFrame);
+    }
+    vector<QRect> bounds(frames->frameCount());
+    QtConcurrent::blockingMap(candidates, [this, &bounds, size, target](const int &frame) {
+        bounds[frame] = PixelKernels::colorBounds(frames->constBits(frame), size, target);
+    });
+
+    //!
+    //! \brief Recolor The rows of one frame that hold the color
+    //!
+    struct Recolor {
+        Pixel *rows;
+        qsizetype count;
+    };
+    vector<Recolor> recolors;
+    bool sharedChanged = false;
+
+    history.beginOperation();
+    for(int frame : candidates) {
+        if(bounds[frame].isEmpty()) continue;
+
+        // Shared frames get their own pixels here, so each one can then be recolored on its own thread
+        sharedChanged = sharedChanged || frames->isShared(frame);
+        history.touch(*frames, frame, bounds[frame]);
+        recolors.push_back(Recolor { frames->scanLine(frame, bounds[frame].top()), qsizetype(bounds[frame].height()) * size });
     }
+    QtConcurrent::blockingMap(recolors, [=](const Recolor &recolor) {
+        PixelKernels::replaceColor(recolor.rows, recolor.count, target, replacement);
+    });
+
+    // Frames that were shared are still identical, so share them again
+    if(sharedChanged)
+        frames->deduplicate();
+    endHistoryOperation();
+    if(!recolors.empty())
+        repaintFrame();
 }
 
 //!
-//! \brief FrameEditor::fillShapeSize Fills a shape with a specified size
-//! \param centerPoint The center point to start drawing from
-//! \param size The size of the shape
+//! \brief FrameEditor::drawSegment Draws a line with the brush, a run of pixels at a time. A one pixel brush draws the
+//!        line's runs directly, a larger one stamps its circle on every pixel of the line.
+//! \param from Where the line starts, in frame coordinates
+//! \param to Where the line ends, in frame coordinates
+//! \param pixel The pixel to draw
 //!
-void FrameEditor::fillShapeSize(QPointF centerPoint, QSize size) {
-    // Fills a shape starting from a center point outwards
-    for(int w = -size.width(); w <= size.width(); w++) {
-        for(int h = -size.height(); h <= size.height(); h++) {
-            fillPixel(currentColor, QPointF(centerPoint.x() + w, centerPoint.y() + h));
+void FrameEditor::drawSegment(QPointF from, QPointF to, Pixel pixel) {
+    TraceScope trace("FrameEditor::drawSegment");
+
+    strokeSpans.clear();
+    segmentSpans.clear();
+    PixelKernels::lineSpans(QPoint(qFloor(from.x()), qFloor(from.y())), QPoint(qFloor(to.x()), qFloor(to.y())), segmentSpans);
+    if(brushRadius == 0) {
+        strokeSpans.swap(segmentSpans);
+    } else {
+        const Stamp &brush = stamp(Stamp::Circle, brushRadius, brushRadius);
+        for(const PixelKernels::Span &span : segmentSpans) {
+            for(int x = span.left; x <= span.right; x++)
+                brush.spansAt(QPoint(x, span.y), frames->size(), strokeSpans);
         }
     }
+    drawSpans(pixel);
 }
 
 //!
-//! \brief FrameEditor::fillAllDriver Fills all instances of a color in a grid to a new color
-//! \param fillColor Color to replace old color with
+//! \brief FrameEditor::drawStamp Stamps a shape tool's footprint
+//! \param shape The footprint
+//! \param center Where the footprint is centered, in frame coordinates
+//! \param pixel The pixel to draw
 //!
-void FrameEditor::fillAllDriver(QColor fillColor) {
-    // Loops through the entire grid and fills the color you want to fill
-    for(int row = 0; row < currentMap->height(); ++row) {
-        for(int col = 0; col < currentMap->width(); ++col) {
-            QColor pixelColor = currentMap->toImage().pixelColor(col, row);
-            if (pixelColor == fillColor) {
-                QPoint point(col, row);
-                fillPixel(currentColor, point);
-            }
+void FrameEditor::drawStamp(const Stamp &shape, QPointF center, Pixel pixel) {
+    TraceScope trace("FrameEditor::drawStamp");
+
+    strokeSpans.clear();
+    shape.spansAt(QPoint(qFloor(center.x()), qFloor(center.y())), frames->size(), strokeSpans);
+    drawSpans(pixel);
+}
+
+//!
+//! \brief FrameEditor::drawSpans Writes the runs in strokeSpans into the current frame as part of the stroke. In
+//!        mirror mode each run is reflected across the middle of the frame as a whole.
+//! \param pixel The pixel to write
+//!
+void FrameEditor::drawSpans(Pixel pixel) {
+    int size = frames->size();
+    if(mirror) {
+        size_t count = strokeSpans.size();
+        for(size_t i = 0; i < count; i++) {
+            PixelKernels::Span span = strokeSpans[i];
+            strokeSpans.push_back(PixelKernels::Span { span.y, size - 1 - span.right, size - 1 - span.left });
         }
     }
+
+    beginStroke();
+    QRect frameRect(0, 0, size, size);
+    QRect changed;
+    for(const PixelKernels::Span &span : strokeSpans) {
+        // Runs off the edge of the frame are clipped
+        QRect run = QRect(QPoint(span.left, span.y), QPoint(span.right, span.y)).intersected(frameRect);
+        if(run.isEmpty()) continue;
+
+        history.touch(*frames, currentFrame, run);
+        std::fill_n(frames->scanLine(currentFrame, run.y()) + run.left(), run.width(), pixel);
+        changed |= run;
+    }
+    markDamaged(changed);
 }
 
 //!
-//! \brief FrameEditor::fillPixel Fills one pixel in the frame
-//! \param color The color to fill the pixel
-//! \param point The position of the pixel
+//! \brief FrameEditor::stamp Gets a footprint, rasterizing it the first time it is used
+//! \param shape Whether the footprint is a rectangle or an ellipse
+//! \param radiusX How far it reaches left and right of its center
+//! \param radiusY How far it reaches above and below its center
+//! \return The footprint
 //!
-void FrameEditor::fillPixel(QColor color, QPointF point) {
-    QRect rect(point.x(), point.y(), 1, 1);
+const Stamp &FrameEditor::stamp(Stamp::Shape shape, int radiusX, int radiusY) {
+    auto key = std::make_tuple(int(shape), radiusX, radiusY);
+    auto found = stamps.find(key);
+    if(found == stamps.end())
+        found = stamps.emplace(key, Stamp(shape, radiusX, radiusY)).first;
+    return found->second;
+}
+
+//!
+//! \brief FrameEditor::beginStroke Starts recording a stroke, if one is not already being recorded. Everything drawn
+//!        until the mouse is released is undone as one stroke.
+//!
+void FrameEditor::beginStroke() {
+    if(strokeRecording) return;
+
+    history.beginOperation();
+    strokeRecording = true;
+}
 
-    // If erasor is active, erases the pixel color, else draws the pixel with a color
-    if(color == Qt::transparent && selectedTool == "erasor"){
-        currentPainter->setCompositionMode(QPainter::CompositionMode_Clear);
-        currentPainter->eraseRect(rect);
-        currentPainter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+//!
+//! \brief FrameEditor::markDamaged Records that some of the current frame's pixels changed. The canvas is repainted
+//!        once at the end of the event loop tick, however many pixels a tool changed before then.
+//! \param rect The changed pixels, in frame coordinates
+//!
+void FrameEditor::markDamaged(const QRect &rect) {
+    if (rect.isEmpty()) return;
+
+    damage |= rect;
+    if (!repaintPending) {
+        repaintPending = true;
+        QTimer::singleShot(0, this, &FrameEditor::flushDamage);
+    }
+}
+
+//!
+//! \brief FrameEditor::repaintFrame Marks the whole current frame as changed
+//!
+void FrameEditor::repaintFrame() {
+    markDamaged(QRect(0, 0, frames->size(), frames->size()));
+}
+
+//!
+//! \brief FrameEditor::flushDamage Scales the changed pixels up into the view's buffer and repaints only that part
+//!        of the canvas
+//!
+void FrameEditor::flushDamage() {
+    TraceScope trace("FrameEditor::flushDamage");
+    repaintPending = false;
+    QRect source = damage.intersected(QRect(0, 0, frames->size(), frames->size()));
+    damage = QRect();
+    if (source.isEmpty() || currentFrame >= frames->frameCount()) return;
+
+    // Get the damaged area in view coordinates
+    qreal scale = qreal(viewSize) / frames->size();
+    QRectF target(source.x() * scale, source.y() * scale, source.width() * scale, source.height() * scale);
+
+    if (viewSize % frames->size() == 0) {
+        // Every size the editor offers divides the view, so the pixels can be blown up by a whole number directly
+        Pixel *scaled = reinterpret_cast<Pixel *>(scaledFrame.bits());
+        PixelKernels::upscale(frames->constBits(currentFrame), frames->size(), source, viewSize / frames->size(), scaled, scaledFrame.bytesPerLine() / sizeof(Pixel));
     } else {
-        currentPainter->fillRect(rect, color);
+        // Loaded sprites of other sizes are scaled by a fraction, nearest neighbour, replacing what was there
+        QPainter painter(&scaledFrame);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(target, frames->image(currentFrame), QRectF(source));
     }
-    currentItem->setPixmap(scaledMap());
+
+    currentItem->update(target);
 }
 
 //!
-//! \brief FrameEditor::scaledMap Calculates the scaled map of the current pixmap and then displays it
-//! \return return the resized pixmap
+//! \brief FrameEditor::finishStroke Adds the stroke being drawn, if any, to the undo history
 //!
-QPixmap FrameEditor::scaledMap() {
-    // Get the graphicsView size
-    QRectF viewRect = ui->graphicsView->sceneRect();
+void FrameEditor::finishStroke() {
+    if(!strokeRecording) return;
 
-    // Get the inputted pixmap size
-    QRectF pixmapRect(0, 0, currentMap->width(), currentMap->height());
-    pixmapRect = pixmapRect.translated(viewRect.center() - pixmapRect.center());
+    strokeRecording = false;
+    endHistoryOperation();
+}
 
-    // Perform the scaling, centers the pixmap, and then scales it to graphicsView size
-    QTransform transform;
-    transform.translate(pixmapRect.center().x(), pixmapRect.center().y());
-    transform.scale(viewRect.width() / pixmapRect.width(), viewRect.height() / pixmapRect.height());
-    transform.translate(-pixmapRect.center().x(), -pixmapRect.center().y());
+//!
+//! \brief FrameEditor::endHistoryOperation Finishes recording an operation and lets the view know what can be undone
+//!
+void FrameEditor::endHistoryOperation() {
+    history.endOperation(*frames);
+    emit historyChanged(history.canUndo(), history.canRedo());
+}
 
-    // Apply the transformation and return the resulting pixmap
-    return currentMap->transformed(transform);
+//!
+//! \brief FrameEditor::showHistoryFrame Shows the frame an undo or redo changed
+//! \param frame The frame, or -1 if nothing changed
+//!
+void FrameEditor::showHistoryFrame(int frame) {
+    emit historyChanged(history.canUndo(), history.canRedo());
+    if(frame < 0) return;
+
+    // Undoing a new frame removes it, so the frame may now be past the end
+    currentFrame = qMin(frame, frames->frameCount() - 1);
+    repaintFrame();
+    emit changeFrameNumber(currentFrame + 1);
 }
 
 //!
@@ -396,6 +698,10 @@ QPixmap FrameEditor::scaledMap() {
 //! \param size The image size
 //!
 void FrameEditor::updateGridTile(int size) {
+    // Switching between frames of the same size keeps the brush already made
+    if (size == gridTileSize) return;
+    gridTileSize = size;
+
     switch (size){
         case 16:
             ui->graphicsView->setBackgroundBrush(QImage(":/images/Images/gridTile.jpg").scaled(128,128));
@@ -10,11 +10,16 @@
 
 #include <QWidget>
 #include <QMouseEvent>
+#include <map>
+#include <tuple>
 #include <vector>
 #include <QtGui>
 #include <QLabel>
 #include <model.h>
-#include "qgraphicsitem.h"
+#include "pixelkernels.h"
+#include "canvasitem.h"
+#include "stamp.h"
+#include "undohistory.h"
 #include "qgraphicsitem.h"
 #include "ui_frameeditor.h"
 
@@ -25,6 +30,7 @@ class frameEditor;
 class FrameEditor : public QWidget
 {
     Q_OBJECT
+
 public:
     explicit FrameEditor(QWidget *parent = nullptr);
     ~FrameEditor();
@@ -36,33 +42,76 @@ public:
     void activeTool(QString activeTool);
     void activeMirror(bool active);
     void deleteCurrentFrame(Model* model);
+    void duplicateCurrentFrame(Model* model);
     void setupNewFrame(int size, Model* model);
+    void setFillDiagonal(bool diagonal);
+    void setFillTolerance(int tolerance);
+    void setFillAllFrames(bool allFrames);
+    int currentFillTolerance() const;
+    void setBrushRadius(int radius);
+    int currentBrushRadius() const;
+    void undo();
+    void redo();
+    void clearHistory();
+    void unmapFile(const QString &filename);
+    void setUndoMemoryLimit(int megabytes);
+    int undoMemoryLimit() const;
+    const UndoHistory &undoHistory() const { return history; }
     QString selectedTool;
 
+    // The tools, as the mouse handlers run them, so the tests and benchmarks can drive them without mouse events
+    void fillDriver(QPointF point);
+    void fillAllDriver(QColor color);
+    void drawSegment(QPointF from, QPointF to, Pixel pixel);
+    void drawStamp(const Stamp &shape, QPointF center, Pixel pixel);
+    const Stamp &stamp(Stamp::Shape shape, int radiusX, int radiusY);
+    void finishStroke();
+    void repaintFrame();
+
 private:
     int sizeValue;
     bool mirror;
-    QPixmap *currentMap;
-    QGraphicsPixmapItem *currentItem;
-    QPainter *currentPainter;
+    bool fillDiagonal;
+    int fillTolerance;
+    int brushRadius;
+    bool fillAllFrames;
+    FrameStore *frames;
+    int currentFrame;
+    CanvasItem *currentItem;
+    QImage scaledFrame;
+    QRect damage;
+    bool repaintPending;
+    UndoHistory history;
+    bool strokeRecording;
+    bool strokePending;
+    QPointF pendingPoint;
+    vector<PixelKernels::Span> strokeSpans;
+    vector<PixelKernels::Span> fillSpans;
+    vector<PixelKernels::Span> segmentSpans;
+    std::map<std::tuple<int, int, int>, Stamp> stamps;
     QGraphicsScene *scene;
+    int gridTileSize;
     QColor currentColor;
     Ui::frameEditor *ui;
-    void fillPixel(QColor color, QPointF point);
-    void fillShapeSize(QPointF centerPoint, QSize size);
-    void fillDriver(QColor color, QPointF point);
-    void fillAllDriver(QColor color);
     void handlePaintAction(QPointF point);
     void updateGridTile(int size);
-    QPixmap scaledMap();
+    void markDamaged(const QRect &rect);
+    void flushDamage();
+    void drawSpans(Pixel pixel);
+    void beginStroke();
+    void flushStroke();
+    QPointF toFramePoint(QPointF position) const;
+    void endHistoryOperation();
+    void showHistoryFrame(int frame);
 
 signals:
     void changeFrameNumber(int frameNumber);
     void changeCurrentColor(QColor color);
+    void historyChanged(bool canUndo, bool canRedo);
 
 protected:
     bool mouseHeld = false;
-    QPointF* lastPoint = nullptr;
+    QPointF lastPoint;
     bool eventFilter(QObject *obj, QEvent *event) override;
 };
 
@@ -0,0 +1,154 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "framepool.h"
+#include <QMutex>
+#include <unordered_map>
+#include <vector>
+
+using std::vector;
+
+// Frames are aligned to a cache line so the pixel kernels can use aligned vector loads
+static const size_t frameAlignment = 64;
+
+// How much freed memory is kept for reuse before blocks are given back to the system
+static const qint64 defaultLimit = 64 * 1024 * 1024;
+
+//!
+//! \brief PoolState The free blocks, one list per block size, and the usage counts
+//!
+struct PoolState {
+    QMutex mutex;
+    std::unordered_map<qsizetype, vector<void *>> freeBlocks;
+    FramePool::Usage usage;
+    qint64 limit = defaultLimit;
+
+    void updatePeak() {
+        usage.peakBytes = qMax(usage.peakBytes, usage.liveBytes + usage.pooledBytes);
+    }
+};
+
+//!
+//! \brief pool Gets the pool. It is never destroyed, so frames freed while the program exits can still be returned.
+//!
+static PoolState &pool() {
+    static PoolState *state = new PoolState;
+    return *state;
+}
+
+//!
+//! \brief FramePool::allocate Gets a block for a frame's pixels, reusing a freed one of the same size if there is one.
+//!        The block's contents are undefined.
+//! \param bytes The size of the block
+//! \return The block, aligned to a cache line
+//!
+void *FramePool::allocate(qsizetype bytes) {
+    PoolState &state = pool();
+    {
+        QMutexLocker lock(&state.mutex);
+        state.usage.liveBlocks++;
+        state.usage.liveBytes += bytes;
+
+        auto found = state.freeBlocks.find(bytes);
+        if (found != state.freeBlocks.end() && !found->second.empty()) {
+            void *block = found->second.back();
+            found->second.pop_back();
+            state.usage.pooledBlocks--;
+            state.usage.pooledBytes -= bytes;
+            return block;
+        }
+        state.updatePeak();
+    }
+
+    void *block = qMallocAligned(bytes, frameAlignment);
+    Q_CHECK_PTR(block);
+    return block;
+}
+
+//!
+//! \brief FramePool::release Gives back a block from allocate. It is kept for reuse unless the pool is full.
+//! \param block The block, may be null
+//! \param bytes The size it was allocated with
+//!
+void FramePool::release(void *block, qsizetype bytes) {
+    if (!block)
+        return;
+
+    PoolState &state = pool();
+    {
+        QMutexLocker lock(&state.mutex);
+        state.usage.liveBlocks--;
+        state.usage.liveBytes -= bytes;
+
+        if (state.usage.pooledBytes + bytes <= state.limit) {
+            state.freeBlocks[bytes].push_back(block);
+            state.usage.pooledBlocks++;
+            state.usage.pooledBytes += bytes;
+            return;
+        }
+    }
+    qFreeAligned(block);
+}
+
+//!
+//! \brief FramePool::trim Gives every pooled block back to the system
+//!
+void FramePool::trim() {
+    PoolState &state = pool();
+    std::unordered_map<qsizetype, vector<void *>> freed;
+    {
+        QMutexLocker lock(&state.mutex);
+        freed.swap(state.freeBlocks);
+        state.usage.pooledBlocks = 0;
+        state.usage.pooledBytes = 0;
+    }
+
+    for (auto &blocks : freed) {
+        for (void *block : blocks.second)
+            qFreeAligned(block);
+    }
+}
+
+//!
+//! \brief FramePool::setLimit Sets how much freed memory is kept for reuse, giving back whatever is over it
+//! \param bytes The most pooled bytes, 0 to keep nothing
+//!
+void FramePool::setLimit(qint64 bytes) {
+    PoolState &state = pool();
+    vector<void *> freed;
+    {
+        QMutexLocker lock(&state.mutex);
+        state.limit = qMax<qint64>(0, bytes);
+        for (auto &blocks : state.freeBlocks) {
+            while (state.usage.pooledBytes > state.limit && !blocks.second.empty()) {
+                freed.push_back(blocks.second.back());
+                blocks.second.pop_back();
+                state.usage.pooledBlocks--;
+                state.usage.pooledBytes -= blocks.first;
+            }
+        }
+    }
+
+    for (void *block : freed)
+        qFreeAligned(block);
+}
+
+//!
+//! \brief FramePool::limit Gets how much freed memory is kept for reuse
+//! \return The most pooled bytes
+//!
+qint64 FramePool::limit() {
+    QMutexLocker lock(&pool().mutex);
+    return pool().limit;
+}
+
+//!
+//! \brief FramePool::usage Gets how much memory frame pixels use right now
+//! \return The usage
+//!
+FramePool::Usage FramePool::usage() {
+    QMutexLocker lock(&pool().mutex);
+    return pool().usage;
+}
@@ -0,0 +1,43 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QtGlobal>
+
+//!
+//! \brief FramePool Hands out the cache line aligned blocks frame pixels live in, and keeps freed blocks to reuse for
+//!        the next frame of the same size instead of returning them to the system. Deleting frames, undoing and
+//!        opening another project of the same canvas size then cost no allocations. Shared by every frame store and
+//!        safe to use from any thread.
+//!
+class FramePool
+{
+public:
+    //!
+    //! \brief Usage How much memory frame pixels use
+    //!
+    struct Usage {
+        // Blocks holding a frame's pixels, and their size in bytes
+        qint64 liveBlocks = 0;
+        qint64 liveBytes = 0;
+        // Freed blocks kept for reuse
+        qint64 pooledBlocks = 0;
+        qint64 pooledBytes = 0;
+        // The most live and pooled bytes held at once
+        qint64 peakBytes = 0;
+    };
+
+    static void *allocate(qsizetype bytes);
+    static void release(void *block, qsizetype bytes);
+    static void trim();
+
+    static void setLimit(qint64 bytes);
+    static qint64 limit();
+    static Usage usage();
+};
+
+#endif // FRAMEPOOL_H
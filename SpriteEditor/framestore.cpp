@@ -0,0 +1,346 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "framestore.h"
+#include <QFileInfo>
+#include <QHash>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <unordered_map>
+
+//!
+//! \brief FrameStore::FrameStore Constructor
+//! \param size The width and height of every frame
+//!
+FrameStore::FrameStore(int size) : frameSize(size) {
+}
+
+//!
+//! \brief FrameStore::~FrameStore Destructor, the frame buffers free themselves once no frame uses them
+//!
+FrameStore::~FrameStore() {
+}
+
+//!
+//! \brief FrameStore::reset Removes every frame and changes the frame size
+//! \param size The new width and height of the frames
+//!
+void FrameStore::reset(int size) {
+    frames.clear();
+    frameSize = size;
+}
+
+//!
+//! \brief FrameStore::swap Exchanges all frames with another store
+//! \param other The store to swap with
+//!
+void FrameStore::swap(FrameStore &other) {
+    std::swap(frameSize, other.frameSize);
+    frames.swap(other.frames);
+}
+
+//!
+//! \brief FrameStore::snapshot Publishes the frames as they are now. The snapshot shares every frame's pixels the
+//!        same way duplicateFrame does, so taking one copies no pixels. Writing to a frame of this store afterwards
+//!        gives the frame its own copy first, which leaves the snapshot untouched, so it can be read on another thread
+//!        with no locking while editing carries on here. Only the thread editing the store may take snapshots.
+//! \return The snapshot
+//!
+FrameSnapshot FrameStore::snapshot() const {
+    auto published = std::make_shared<FrameStore>(frameSize);
+    published->frames = frames;
+    return published;
+}
+
+//!
+//! \brief FrameStore::allocateFrame Allocates one transparent frame buffer
+//! \return The new buffer
+//!
+std::shared_ptr<FrameStore::FrameBuffer> FrameStore::allocateFrame() const {
+    Pixel *bits = static_cast<Pixel *>(FramePool::allocate(frameBytes()));
+    std::memset(bits, 0, frameBytes());
+    return std::make_shared<FrameBuffer>(bits, frameBytes());
+}
+
+//!
+//! \brief FrameStore::nextVersion Hands out frame versions, shared by every store and safe to call from any thread
+//! \return A version no frame has had before, never 0
+//!
+quint64 FrameStore::nextVersion() {
+    static std::atomic<quint64> counter(0);
+    return ++counter;
+}
+
+//!
+//! \brief FrameStore::separate Gives a frame its own copy of pixels it shares with other frames
+//! \param frame The frame about to be written to
+//!
+void FrameStore::separate(Frame &frame) {
+    Pixel *bits = static_cast<Pixel *>(FramePool::allocate(frameBytes()));
+    std::memcpy(bits, frame.buffer->pixels(), frameBytes());
+    frame.buffer = std::make_shared<FrameBuffer>(bits, frameBytes());
+}
+
+//!
+//! \brief FrameStore::addFrame Appends a transparent frame
+//! \return The index of the new frame
+//!
+int FrameStore::addFrame() {
+    frames.push_back(Frame { allocateFrame(), nextVersion() });
+    return frameCount() - 1;
+}
+
+//!
+//! \brief FrameStore::addExternalFrame Appends a frame whose pixels live in memory the store does not allocate, such
+//!        as a copy-on-write file mapping. The pixels must stay writable and valid for as long as owner is alive.
+//! \param bits The frame's size * size pixels
+//! \param owner Keeps the memory alive, it is released when the frame is removed
+//! \param fileName The file the memory is mapped from, if any, so it can be unmapped before the file is replaced
+//! \return The index of the new frame
+//!
+int FrameStore::addExternalFrame(Pixel *bits, const std::shared_ptr<void> &owner, const QString &fileName) {
+    frames.push_back(Frame { std::make_shared<FrameBuffer>(bits, frameBytes(), owner, fileName), nextVersion() });
+    return frameCount() - 1;
+}
+
+//!
+//! \brief FrameStore::addLazyFrame Appends a frame that is decoded from a source the first time it is used. The
+//!        source is released once every frame from it has been written to or removed.
+//! \param source Where to decode the frame from
+//! \param sourceFrame The frame's number in the source
+//! \return The index of the new frame
+//!
+int FrameStore::addLazyFrame(const std::shared_ptr<const FrameSource> &source, int sourceFrame) {
+    frames.push_back(Frame { std::make_shared<FrameBuffer>(source, sourceFrame, frameBytes()), nextVersion() });
+    return frameCount() - 1;
+}
+
+//!
+//! \brief FrameStore::source Gets where a frame that has not been written to since it was opened came from, whether
+//!        or not it has been decoded yet
+//! \param frame The frame
+//! \param sourceFrame Set to the frame's number in the source
+//! \return The source, or nullptr if the frame's pixels have been written to or did not come from a source
+//!
+std::shared_ptr<const FrameSource> FrameStore::source(int frame, int *sourceFrame) const {
+    FrameBuffer *buffer = frames[frame].buffer.get();
+
+    // Decoding on another thread reads the source
+    std::lock_guard<std::mutex> lock(buffer->decoding);
+    if (sourceFrame) *sourceFrame = buffer->sourceFrame;
+    return buffer->source;
+}
+
+//!
+//! \brief FrameStore::unmapped Gets pixels that no longer depend on a file being mapped. Windows will not replace a
+//!        file while any of it is mapped, so frames mapped from a file are copied before saving over it.
+//! \param pixels The pixels, from sharedFrame
+//! \param filename The file about to be replaced (includes path)
+//! \return A copy of the pixels if they are mapped from the file, otherwise the pixels themselves
+//!
+FrameStore::SharedFrame FrameStore::unmapped(const SharedFrame &pixels, const QString &filename) const {
+    if (!pixels->owner || pixels->mappedFile.isEmpty() || !(QFileInfo(pixels->mappedFile) == QFileInfo(filename)))
+        return pixels;
+
+    SharedFrame copy = allocateFrame();
+    std::memcpy(copy->bits.load(std::memory_order_relaxed), pixels->pixels(), frameBytes());
+    return copy;
+}
+
+//!
+//! \brief FrameStore::unmapFile Copies every frame mapped from a file into memory of its own, so the file is closed
+//!        once nothing else holds on to those frames. Frames that shared pixels still share the copy, and since the
+//!        pixels are the same the frames keep their versions.
+//! \param filename The file about to be replaced (includes path)
+//! \return How many frames were copied
+//!
+int FrameStore::unmapFile(const QString &filename) {
+    // The originals are kept until the end, so a copy never reuses the address of one still to be looked up
+    std::unordered_map<FrameBuffer *, std::pair<SharedFrame, SharedFrame>> copies;
+    int copied = 0;
+    for (Frame &frame : frames) {
+        FrameBuffer *buffer = frame.buffer.get();
+        auto found = copies.find(buffer);
+        if (found == copies.end())
+            found = copies.emplace(buffer, std::make_pair(frame.buffer, unmapped(frame.buffer, filename))).first;
+        if (found->second.second != frame.buffer) {
+            frame.buffer = found->second.second;
+            copied++;
+        }
+    }
+    return copied;
+}
+
+//!
+//! \brief FrameStore::forgetSources Releases the source of every decoded frame that came from a file, so that file is
+//!        closed and unmapped before it is replaced. This changes no pixels, so it is safe on a snapshot while the
+//!        frames it shares are being edited; the frames are just saved in full rather than as references from then on.
+//! \param filename The file about to be replaced (includes path)
+//!
+void FrameStore::forgetSources(const QString &filename) const {
+    QFileInfo target(filename);
+    const FrameSource *checked = nullptr;
+    bool matches = false;
+    for (const Frame &frame : frames) {
+        FrameBuffer *buffer = frame.buffer.get();
+        std::lock_guard<std::mutex> lock(buffer->decoding);
+        if (!buffer->source || !buffer->bits.load(std::memory_order_acquire))
+            continue;
+
+        // Frames from the same source are usually next to each other
+        if (buffer->source.get() != checked) {
+            checked = buffer->source.get();
+            matches = QFileInfo(checked->fileName()) == target;
+        }
+        if (matches)
+            buffer->source.reset();
+    }
+}
+
+//!
+//! \brief FrameStore::FrameBuffer::decode Decodes the buffer's pixels from its source. A frame the source cannot
+//!        decode is shown transparent and marked failed, so it is never saved in place of the real pixels. Only the
+//!        first caller decodes, any others at the same time wait for it.
+//! \return The pixels
+//!
+Pixel *FrameStore::FrameBuffer::decode() {
+    std::lock_guard<std::mutex> lock(decoding);
+    Pixel *decoded = bits.load(std::memory_order_acquire);
+    if (decoded)
+        return decoded;
+
+    decoded = static_cast<Pixel *>(FramePool::allocate(bytes));
+    if (!source->decodeFrame(sourceFrame, decoded)) {
+        qWarning("Frame %d could not be decoded and was left transparent", sourceFrame);
+        std::memset(decoded, 0, bytes);
+        failed.store(true, std::memory_order_release);
+    }
+    bits.store(decoded, std::memory_order_release);
+    return decoded;
+}
+
+//!
+//! \brief FrameStore::FrameBuffer::forgetSource Decodes the buffer if it has not been yet and releases its source, as
+//!        its pixels are about to be written to and will no longer match it
+//!
+void FrameStore::FrameBuffer::forgetSource() {
+    pixels();
+    std::lock_guard<std::mutex> lock(decoding);
+    source.reset();
+}
+
+//!
+//! \brief FrameStore::insertFrame Inserts a transparent frame
+//! \param index The index the new frame will have
+//!
+void FrameStore::insertFrame(int index) {
+    frames.insert(frames.begin() + index, Frame { allocateFrame(), nextVersion() });
+}
+
+//!
+//! \brief FrameStore::insertFrame Inserts a frame showing pixels held on to from this store, sharing them rather than
+//!        copying them
+//! \param index The index the new frame will have
+//! \param pixels The pixels, from sharedFrame
+//!
+void FrameStore::insertFrame(int index, const SharedFrame &pixels) {
+    frames.insert(frames.begin() + index, Frame { pixels, nextVersion() });
+}
+
+//!
+//! \brief FrameStore::removeFrame Removes a frame, freeing its pixels unless another frame shares them
+//! \param index The frame to remove
+//!
+void FrameStore::removeFrame(int index) {
+    frames.erase(frames.begin() + index);
+}
+
+//!
+//! \brief FrameStore::moveFrame Moves a frame to a new position, shifting the frames in between
+//! \param from The current index of the frame
+//! \param to The index the frame will have afterwards
+//!
+void FrameStore::moveFrame(int from, int to) {
+    if (from < to)
+        std::rotate(frames.begin() + from, frames.begin() + from + 1, frames.begin() + to + 1);
+    else if (from > to)
+        std::rotate(frames.begin() + to, frames.begin() + from, frames.begin() + from + 1);
+}
+
+//!
+//! \brief FrameStore::duplicateFrame Inserts a copy of a frame after it. The copy shares the frame's pixels until one
+//!        of them is written to, so this does not copy anything.
+//! \param index The frame to copy
+//! \return The index of the copy
+//!
+int FrameStore::duplicateFrame(int index) {
+    Frame copy = frames[index];
+    frames.insert(frames.begin() + index + 1, std::move(copy));
+    return index + 1;
+}
+
+//!
+//! \brief FrameStore::deduplicate Finds frames with identical pixels and makes them share one buffer. Frames are
+//!        grouped by a hash of their pixels, which is kept until they are written to, and only frames with the same
+//!        hash are compared. Every frame is read, decoding any not decoded yet, so it is only worth running on frames
+//!        that are in memory anyway rather than on frames mapped from a file.
+//! \return The number of frames that share their pixels with an earlier frame
+//!
+int FrameStore::deduplicate() {
+    std::unordered_map<size_t, vector<int>> framesByHash;
+    int shared = 0;
+
+    for (int i = 0; i < frameCount(); i++) {
+        Frame &frame = frames[i];
+        if (!frame.hashed) {
+            frame.hash = qHashBits(frame.buffer->pixels(), frameBytes());
+            frame.hashed = true;
+        }
+
+        // Share the first earlier frame that really has the same pixels
+        vector<int> &candidates = framesByHash[frame.hash];
+        auto match = std::find_if(candidates.begin(), candidates.end(), [&](int other) {
+            FrameBuffer *buffer = frames[other].buffer.get();
+            return buffer == frame.buffer.get() || std::memcmp(buffer->pixels(), frame.buffer->pixels(), frameBytes()) == 0;
+        });
+        if (match != candidates.end()) {
+            frame.buffer = frames[*match].buffer;
+            frame.version = frames[*match].version;
+            shared++;
+        } else {
+            candidates.push_back(i);
+        }
+    }
+    return shared;
+}
+
+//!
+//! \brief FrameStore::image Wraps a frame in a QImage without copying it. The image is only valid until the frame is
+//!        removed, and must not be written to.
+//! \param frame The frame to wrap
+//! \return The image
+//!
+QImage FrameStore::image(int frame) const {
+    return QImage(reinterpret_cast<const uchar *>(constBits(frame)), frameSize, frameSize, bytesPerLine(), QImage::Format_RGBA8888);
+}
+
+//!
+//! \brief FrameStore::fromColor Converts a QColor into a pixel
+//! \param color The color to convert
+//! \return The pixel
+//!
+Pixel FrameStore::fromColor(const QColor &color) {
+    return packPixel(color.red(), color.green(), color.blue(), color.alpha());
+}
+
+//!
+//! \brief FrameStore::toColor Converts a pixel into a QColor
+//! \param pixel The pixel to convert
+//! \return The color
+//!
+QColor FrameStore::toColor(Pixel pixel) {
+    return QColor(pixelChannel(pixel, 0), pixelChannel(pixel, 1), pixelChannel(pixel, 2), pixelChannel(pixel, 3));
+}
@@ -0,0 +1,228 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef FRAMESTORE_H
+#define FRAMESTORE_H
+
+#include "framepool.h"
+#include <QByteArray>
+#include <QColor>
+#include <QImage>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief Pixel One RGBA8 pixel, laid out in memory as the bytes r, g, b, a (the same as QImage::Format_RGBA8888)
+//!
+typedef quint32 Pixel;
+
+//!
+//! \brief packPixel Builds a pixel from its four 0-255 channels
+//!
+inline Pixel packPixel(int r, int g, int b, int a) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return quint32(r) | quint32(g) << 8 | quint32(b) << 16 | quint32(a) << 24;
+#else
+    return quint32(r) << 24 | quint32(g) << 16 | quint32(b) << 8 | quint32(a);
+#endif
+}
+
+//!
+//! \brief pixelChannel Reads one channel out of a pixel
+//! \param channel 0 for red, 1 for green, 2 for blue and 3 for alpha
+//!
+inline int pixelChannel(Pixel pixel, int channel) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    return (pixel >> (8 * channel)) & 0xff;
+#else
+    return (pixel >> (8 * (3 - channel))) & 0xff;
+#endif
+}
+
+//!
+//! \brief FrameSource Somewhere frames can be decoded from when they are first needed, such as an open project file
+//!
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    //!
+    //! \brief decodeFrame Decodes one frame's pixels. Must be safe to call for different frames at the same time.
+    //! \param frame The frame's number in the source
+    //! \param bits The size * size pixel buffer to decode into
+    //! \return Whether the frame could be decoded
+    //!
+    virtual bool decodeFrame(int frame, Pixel *bits) const = 0;
+
+    //!
+    //! \brief fileName Gets the file the frames are decoded from
+    //! \return The file (includes path), or an empty string if the frames do not come from a file
+    //!
+    virtual QString fileName() const { return QString(); }
+
+    //!
+    //! \brief fileStamp Gets the size and modification time the file had when it was opened, which tells whether the
+    //!        file still holds the same frames
+    //!
+    virtual QByteArray fileStamp() const { return QByteArray(); }
+};
+
+class FrameStore;
+
+//!
+//! \brief FrameSnapshot A read only version of the frames, see FrameStore::snapshot. It can be read from any thread,
+//!        and the pixels it shares are kept alive until the last copy of it is dropped.
+//!
+typedef std::shared_ptr<const FrameStore> FrameSnapshot;
+
+//!
+//! \brief FrameStore Owns the pixels of every frame in the sprite. Each frame is one contiguous, cache line aligned
+//!        block of size * size RGBA8 pixels, so tools and file I/O can work on raw scanlines.
+//!
+//!        Frames with the same pixels can share one block. The block is reference counted and copied the first time
+//!        one of the frames sharing it is written through bits() or scanLine(), so duplicating a frame is O(1) and
+//!        repeated frames, such as the held poses of an idle loop, are only stored once. Sharing is by whole frame,
+//!        so frames that differ in a single pixel each have their own block.
+//!
+//!        Frames can also be added undecoded, from a FrameSource. Their pixels are decoded the first time anything
+//!        reads or writes them, so a large project opens without decoding frames nobody has looked at yet.
+//!
+//!        Other threads never read a store that is being edited. They read a snapshot instead, an immutable store
+//!        sharing every frame's pixels, which stays exactly as it was when taken however the original is edited.
+//!
+class FrameStore
+{
+    struct FrameBuffer;
+
+public:
+    //!
+    //! \brief SharedFrame A frame's pixels held on to outside the store, such as by the undo history for a frame that
+    //!        was removed. Holding them copies nothing, and they can be put back with insertFrame.
+    //!
+    typedef std::shared_ptr<FrameBuffer> SharedFrame;
+
+    explicit FrameStore(int size = 32);
+    ~FrameStore();
+
+    FrameStore(const FrameStore &) = delete;
+    FrameStore &operator=(const FrameStore &) = delete;
+
+    int size() const { return frameSize; }
+    int frameCount() const { return (int)frames.size(); }
+    int bytesPerLine() const { return frameSize * (int)sizeof(Pixel); }
+    qsizetype frameBytes() const { return qsizetype(frameSize) * bytesPerLine(); }
+    bool contains(int x, int y) const { return x >= 0 && y >= 0 && x < frameSize && y < frameSize; }
+
+    void reset(int size);
+    void swap(FrameStore &other);
+    FrameSnapshot snapshot() const;
+    int addFrame();
+    int addExternalFrame(Pixel *bits, const std::shared_ptr<void> &owner, const QString &fileName = QString());
+    int addLazyFrame(const std::shared_ptr<const FrameSource> &source, int sourceFrame);
+    void insertFrame(int index);
+    void insertFrame(int index, const SharedFrame &pixels);
+    SharedFrame sharedFrame(int frame) const { return frames[frame].buffer; }
+    SharedFrame unmapped(const SharedFrame &pixels, const QString &filename) const;
+    int unmapFile(const QString &filename);
+    void forgetSources(const QString &filename) const;
+    void removeFrame(int index);
+    void moveFrame(int from, int to);
+    int duplicateFrame(int index);
+    int deduplicate();
+    bool isShared(int frame) const { return frames[frame].buffer.use_count() > 1; }
+    quint64 version(int frame) const { return frames[frame].version; }
+    bool isDecoded(int frame) const { return frames[frame].buffer->bits.load(std::memory_order_acquire) != nullptr; }
+    bool isCorrupt(int frame) const { return frames[frame].buffer->failed.load(std::memory_order_acquire); }
+    std::shared_ptr<const FrameSource> source(int frame, int *sourceFrame = nullptr) const;
+
+    Pixel pixel(int frame, int x, int y) const { return constScanLine(frame, y)[x]; }
+    void setPixel(int frame, int x, int y, Pixel pixel) { scanLine(frame, y)[x] = pixel; }
+
+    Pixel *bits(int frame) { detach(frame); return frames[frame].buffer->pixels(); }
+    const Pixel *constBits(int frame) const { return frames[frame].buffer->pixels(); }
+    Pixel *scanLine(int frame, int y) { return bits(frame) + qsizetype(y) * frameSize; }
+    const Pixel *constScanLine(int frame, int y) const { return constBits(frame) + qsizetype(y) * frameSize; }
+
+    QImage image(int frame) const;
+
+    static Pixel fromColor(const QColor &color);
+    static QColor toColor(Pixel pixel);
+
+private:
+    //!
+    //! \brief FrameBuffer One block of frame pixels, shared by every frame showing them. Gives the pixels back to the
+    //!        frame pool, or for pixels that live in memory owned by something else (such as a mapped file, whose name
+    //!        it keeps) just drops the reference keeping that memory alive. A buffer from a FrameSource has no pixels
+    //!        until they are first asked for, and remembers the source until it is written to.
+    //!
+    struct FrameBuffer {
+        FrameBuffer(Pixel *bits, qsizetype bytes, const std::shared_ptr<void> &owner = nullptr, const QString &mappedFile = QString())
+            : bits(bits), owner(owner), mappedFile(mappedFile), bytes(bytes) {}
+        FrameBuffer(const std::shared_ptr<const FrameSource> &source, int sourceFrame, qsizetype bytes)
+            : bits(nullptr), source(source), sourceFrame(sourceFrame), bytes(bytes) {}
+        FrameBuffer(const FrameBuffer &) = delete;
+        FrameBuffer &operator=(const FrameBuffer &) = delete;
+        ~FrameBuffer() { if (!owner) FramePool::release(bits.load(), bytes); }
+
+        //!
+        //! \brief pixels Gets the pixels, decoding them first if they have not been yet
+        //!
+        Pixel *pixels() {
+            Pixel *decoded = bits.load(std::memory_order_acquire);
+            return decoded ? decoded : decode();
+        }
+        Pixel *decode();
+        void forgetSource();
+
+        std::atomic<Pixel *> bits;
+        std::shared_ptr<void> owner;
+        QString mappedFile;
+        std::shared_ptr<const FrameSource> source;
+        int sourceFrame = 0;
+        qsizetype bytes = 0;
+        std::atomic<bool> failed { false };
+        std::mutex decoding;
+    };
+
+    //!
+    //! \brief Frame One frame's pixels, and a hash of them that is kept until the frame is next written to. The
+    //!        version changes every time the frame may have been written to, and is never reused, so caches of what a
+    //!        frame looks like can tell when they are stale.
+    //!
+    struct Frame {
+        std::shared_ptr<FrameBuffer> buffer;
+        quint64 version = 0;
+        size_t hash = 0;
+        bool hashed = false;
+    };
+
+    int frameSize;
+    vector<Frame> frames;
+    std::shared_ptr<FrameBuffer> allocateFrame() const;
+    void separate(Frame &frame);
+    static quint64 nextVersion();
+
+    //!
+    //! \brief detach Gets a frame ready to be written, giving it its own copy of its pixels if they are shared
+    //!
+    void detach(int frame) {
+        Frame &target = frames[frame];
+        target.hashed = false;
+        target.version = nextVersion();
+        if (target.buffer.use_count() > 1)
+            separate(target);
+        else if (target.buffer->source)
+            target.buffer->forgetSource();
+    }
+};
+
+#endif // FRAMESTORE_H
@@ -5,15 +5,39 @@
  * Code Reviewed By: Alex Elbel
  */
 
+#include "framepool.h"
 #include "mainwindow.h"
+#include "trace.h"
 #include <QApplication>
+#include <QDir>
+#include <QStandardPaths>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // SPRITE_EDITOR_TRACE=<file> records from startup and saves the trace when the editor closes
+    QString traceFile = qEnvironmentVariable("SPRITE_EDITOR_TRACE");
+    if (!traceFile.isEmpty()) Trace::setEnabled(true);
+
+    // SPRITE_EDITOR_FRAME_POOL_MB=<megabytes> sets how much freed frame memory is kept for reuse, 0 keeps none
+    bool poolLimitSet;
+    int poolLimit = qEnvironmentVariableIntValue("SPRITE_EDITOR_FRAME_POOL_MB", &poolLimitSet);
+    if (poolLimitSet) FramePool::setLimit(qint64(poolLimit) * 1024 * 1024);
+
     Model model;
 
+    // Frames are checkpointed into a journal in the background, and a journal left by a crash is replayed if the user
+    // wants it back
+    QString autosaveDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    bool autosaving = QDir().mkpath(autosaveDir) && model.startAutosave(autosaveDir + "/autosave.sspj");
+
     MainWindow w(&model);
     w.show();
-    return a.exec();
+    if (autosaving) w.offerAutosaveRecovery();
+    int result = a.exec();
+
+    if (!traceFile.isEmpty() && !Trace::save(traceFile))
+        qWarning("Unable to write the trace to %s", qPrintable(traceFile));
+    return result;
 }
@@ -6,6 +6,7 @@
  */
 
 #include "mainwindow.h"
+#include "trace.h"
 
 //!
 //! \brief MainWindow::MainWindow - Constructor for main window,
@@ -53,10 +54,27 @@ MainWindow::MainWindow(Model* model, QWidget *parent)
     connect(ui->actionBrush, &QAction::triggered, this, &MainWindow::actionBrushToggled);
     connect(ui->actionFill, &QAction::triggered, this, &MainWindow::actionFillToggled);
     connect(ui->actionFill_All, &QAction::triggered, this, &MainWindow::actionFillAllToggled);
+    connect(ui->actionFill_Diagonal, &QAction::toggled, ui->frameEditor, &FrameEditor::setFillDiagonal);
+    connect(ui->actionFill_All_Frames, &QAction::toggled, ui->frameEditor, &FrameEditor::setFillAllFrames);
+    connect(ui->actionFill_Tolerance, &QAction::triggered, this, &MainWindow::actionFillToleranceTriggered);
+    connect(ui->actionBrush_Size, &QAction::triggered, this, &MainWindow::actionBrushSizeTriggered);
     connect(ui->actionEyedrop_Tool, &QAction::triggered, this, &MainWindow::actionEyedropToolToggled);
     connect(ui->actionColor_Picker, &QAction::triggered, this, &MainWindow::actionColorPickerToggled);
     connect(ui->actionReadMe, &QAction::triggered, this, &MainWindow::actionReadMeTriggered);
 
+    // Set up tracing, which may already be on from the environment
+    ui->actionRecord_Trace->setChecked(Trace::isEnabled());
+    connect(ui->actionRecord_Trace, &QAction::toggled, &Trace::setEnabled);
+    connect(ui->actionSave_Trace, &QAction::triggered, this, &MainWindow::actionSaveTraceTriggered);
+
+    // Set up undo and redo
+    connect(ui->actionUndo, &QAction::triggered, ui->frameEditor, &FrameEditor::undo);
+    connect(ui->actionRedo, &QAction::triggered, ui->frameEditor, &FrameEditor::redo);
+    connect(ui->actionUndo_Memory_Limit, &QAction::triggered, this, &MainWindow::actionUndoMemoryLimitTriggered);
+    connect(ui->actionCompact_Save, &QAction::toggled, model, &Model::setCompactSave);
+    connect(ui->actionLoad_Save_Threads, &QAction::triggered, this, &MainWindow::actionLoadSaveThreadsTriggered);
+    connect(ui->frameEditor, &FrameEditor::historyChanged, this, &MainWindow::setHistoryActions);
+
     // Set up the connections from the PushButtons to the functions
     connect(ui->newButton, &QPushButton::pressed, this, &MainWindow::actionNewTriggered);
     connect(ui->saveButton, &QPushButton::pressed, this, &MainWindow::actionSaveTriggered);
@@ -82,6 +100,15 @@ MainWindow::MainWindow(Model* model, QWidget *parent)
     // Setup preview
     connect(ui->playPreviewButton, &QPushButton::clicked, this, &MainWindow::onPreviewStart);
     connect(this, &MainWindow::previewPlayed, model, &Model::playPreview);
+    connect(ui->pausePreviewButton, &QPushButton::toggled, model, &Model::pausePreview);
+    connect(ui->stopPreviewButton, &QPushButton::clicked, this, &MainWindow::onPreviewStop);
+    connect(this, &MainWindow::previewStopped, model, &Model::stopPreview);
+    connect(ui->fpsSpinBox, &QSpinBox::valueChanged, model, &Model::setPreviewFps);
+    connect(model, &Model::previewStats, this, &MainWindow::displayPreviewStats);
+    connect(this, &MainWindow::previewScaleChanged, model, &Model::setPreviewScale);
+    connect(ui->scaleToggle, &QCheckBox::toggled, this, &MainWindow::updatePreviewScale);
+    connect(ui->nearestToggle, &QCheckBox::toggled, this, &MainWindow::updatePreviewScale);
+    updatePreviewScale();
     connect(model, &Model::setPreviewFrame, this, &MainWindow::setPreviewFrame);
     connect(ui->loopToggle, &QCheckBox::toggled, model, &Model::toggleLoop);
     ui->previewFrame->setAlignment(Qt::AlignCenter);
@@ -102,14 +129,18 @@ MainWindow::MainWindow(Model* model, QWidget *parent)
     connect(this, &MainWindow::frameChanged, ui->frameEditor, &FrameEditor::changeCurrentFrame);
     connect(ui->deleteFrame, &QPushButton::pressed, this, &MainWindow::deleteFrame);
     connect(this, &MainWindow::frameDeleted, ui->frameEditor, &FrameEditor::deleteCurrentFrame);
+    connect(ui->actionDuplicate_Frame, &QAction::triggered, this, &MainWindow::duplicateFrame);
+    connect(this, &MainWindow::frameDuplicated, ui->frameEditor, &FrameEditor::duplicateCurrentFrame);
 
     connect(this, &MainWindow::activeTool, ui->frameEditor, &FrameEditor::activeTool);
 
     // LoadImage error
     connect(model, &Model::loadImageError, this, &MainWindow::displayOpenImageSizeError);
+    connect(model, &Model::saveImageError, this, &MainWindow::displaySaveImageError);
 
     // LoadImage load frame
     connect(model, &Model::loadFrame, this, &MainWindow::changeFrame);
+    connect(model, &Model::loadFrame, ui->frameEditor, &FrameEditor::clearHistory);
 
     // Set up the cursor
     eraserCursor = QCursor(QCursor(getPixmapFromIcon(QIcon(":/images/Images/eraser-icon.png")), 0, -32));
@@ -122,6 +153,26 @@ MainWindow::MainWindow(Model* model, QWidget *parent)
     circleCursor = QCursor(QCursor(getPixmapFromIcon(QIcon(":/images/Images/circle.png")), 0, 0));
     squareCursor = QCursor(QCursor(getPixmapFromIcon(QIcon(":/images/Images/square.png")), 0, 0));
 
+    // Show how much memory the frames use in the status bar, refreshed every second
+    memoryUsage = new QLabel(this);
+    ui->statusbar->addPermanentWidget(memoryUsage);
+    connect(&memoryTimer, &QTimer::timeout, this, &MainWindow::displayMemoryUsage);
+    memoryTimer.start(1000);
+    displayMemoryUsage();
+
+    // Loads and saves run in the background, with their progress and a way to cancel them in the status bar
+    fileProgress = new QProgressBar(this);
+    cancelFileButton = new QPushButton(tr("Cancel"), this);
+    ui->statusbar->addWidget(fileProgress);
+    ui->statusbar->addWidget(cancelFileButton);
+    fileProgress->hide();
+    cancelFileButton->hide();
+    connect(cancelFileButton, &QPushButton::pressed, model, &Model::cancelFileJob);
+    connect(model, &Model::fileJobStarted, this, &MainWindow::displayFileJobStarted);
+    connect(model, &Model::fileJobProgress, this, &MainWindow::displayFileJobProgress);
+    connect(model, &Model::fileJobFinished, this, &MainWindow::displayFileJobFinished);
+    connect(model, &Model::autosaveRecovered, this, &MainWindow::displayAutosaveRecovered);
+
     fileName = "";
 }
 
@@ -250,6 +301,60 @@ void MainWindow::actionFillToggled(bool toggled) {
     }
 }
 
+//!
+//! \brief MainWindow::actionFillToleranceTriggered Asks the user how close a color must be to the clicked color to be filled
+//!
+void MainWindow::actionFillToleranceTriggered() {
+    bool ok;
+    int tolerance = QInputDialog::getInt(this, tr("Fill Tolerance"), tr("Largest difference in any channel (0-255) that is still filled:"),
+                                         ui->frameEditor->currentFillTolerance(), 0, 255, 1, &ok);
+    if (ok) ui->frameEditor->setFillTolerance(tolerance);
+}
+
+//!
+//! \brief MainWindow::actionBrushSizeTriggered Asks the user how thick the brush and eraser should draw
+//!
+void MainWindow::actionBrushSizeTriggered() {
+    bool ok;
+    int radius = QInputDialog::getInt(this, tr("Brush Size"), tr("Pixels the brush reaches around its center (0 for one pixel):"),
+                                      ui->frameEditor->currentBrushRadius(), 0, 64, 1, &ok);
+    if (ok) ui->frameEditor->setBrushRadius(radius);
+}
+
+//!
+//! \brief MainWindow::actionUndoMemoryLimitTriggered Asks the user how much memory the undo history may use
+//!
+void MainWindow::actionUndoMemoryLimitTriggered() {
+    bool ok;
+    int megabytes = QInputDialog::getInt(this, tr("Undo Memory Limit"), tr("Memory the undo history may use (MB), the oldest changes are forgotten first:"),
+                                         ui->frameEditor->undoMemoryLimit(), 1, 4096, 1, &ok);
+    if (ok) ui->frameEditor->setUndoMemoryLimit(megabytes);
+}
+
+//!
+//! \brief MainWindow::actionLoadSaveThreadsTriggered Asks the user how many threads frames are decoded and encoded on
+//!
+void MainWindow::actionLoadSaveThreadsTriggered() {
+    bool ok;
+    int threads = QInputDialog::getInt(this, tr("Load and Save Threads"), tr("Threads frames are decoded and encoded on when opening and saving:"),
+                                       model->ioThreadCount(), 1, 64, 1, &ok);
+    if (ok) model->setIoThreadCount(threads);
+}
+
+//!
+//! \brief MainWindow::setHistoryActions Enables undo and redo only when there is something to undo or redo
+//! \param canUndo Whether there is an operation to undo
+//! \param canRedo Whether there is an operation to redo
+//!
+void MainWindow::setHistoryActions(bool canUndo, bool canRedo) {
+    this->canUndo = canUndo;
+    this->canRedo = canRedo;
+
+    // Undoing can add or remove frames, so it waits for a load like everything else that does
+    ui->actionUndo->setEnabled(canUndo && !model->isLoading());
+    ui->actionRedo->setEnabled(canRedo && !model->isLoading());
+}
+
 //!
 //! \brief MainWindow::actionEyedropToolToggled Toggles the eyedrop tool
 //! \param toggled What state to toggle it to
@@ -285,6 +390,15 @@ void MainWindow::actionReadMeTriggered() {
     onHelpButtonPressed();
 }
 
+//!
+//! \brief MainWindow::actionSaveTraceTriggered Saves the timings recorded so far as a Chrome trace
+//!
+void MainWindow::actionSaveTraceTriggered() {
+    QString traceName = QFileDialog::getSaveFileName(this, tr("Save Trace"), QDir::currentPath(), tr("Chrome Trace (*.json)"));
+    if (!traceName.isEmpty() && !Trace::save(traceName))
+        QMessageBox::warning(this, tr("Save Trace"), tr("Unable to write %1").arg(traceName));
+}
+
 //!
 //! \brief MainWindow::actionNewTriggered Triggers the shapes menu
 //!
@@ -457,21 +571,173 @@ void MainWindow::deleteFrame(){
     emit frameDeleted(model);
 }
 
+//!
+//! \brief MainWindow::duplicateFrame Sends the signal to duplicate the current frame forward
+//!
+void MainWindow::duplicateFrame(){
+    emit frameDuplicated(model);
+}
+
 //!
 //! \brief MainWindow::onPreviewStart Sends the signal to start the preview forward
 //!
 void MainWindow::onPreviewStart(){
+    ui->pausePreviewButton->setChecked(false);
     emit previewPlayed(ui->fpsSpinBox);
 }
 
+//!
+//! \brief MainWindow::onPreviewStop Sends the signal to stop the preview forward
+//!
+void MainWindow::onPreviewStop(){
+    ui->pausePreviewButton->setChecked(false);
+    emit previewStopped();
+}
+
+//!
+//! \brief MainWindow::displayPreviewStats Shows how closely the preview is keeping to its frame rate
+//! \param achievedFps The frame rate actually shown
+//! \param jitterMs How much frames vary from when they were due, in milliseconds
+//! \param droppedFrames How many frames were skipped because they were due while the editor was busy
+//!
+void MainWindow::displayPreviewStats(double achievedFps, double jitterMs, qint64 droppedFrames){
+    ui->previewStats->setText(tr("%1 fps, %2 ms jitter, %3 dropped").arg(achievedFps, 0, 'f', 1).arg(jitterMs, 0, 'f', 2).arg(droppedFrames));
+}
+
+//!
+//! \brief MainWindow::displayMemoryUsage Shows how many frames there are and how much memory their pixels use, are
+//!        kept pooled for reuse, and used at most
+//!
+void MainWindow::displayMemoryUsage(){
+    FramePool::Usage usage = FramePool::usage();
+    auto megabytes = [](qint64 bytes) { return QString::number(bytes / (1024.0 * 1024.0), 'f', 1); };
+    memoryUsage->setText(tr("%1 frames in %2 buffers, %3 MB in use, %4 MB pooled, %5 MB peak")
+                         .arg(model->frames.frameCount()).arg(usage.liveBlocks)
+                         .arg(megabytes(usage.liveBytes), megabytes(usage.pooledBytes), megabytes(usage.peakBytes)));
+}
+
+//!
+//! \brief MainWindow::displayFileJobStarted Shows the progress bar for a load or save, and stops anything that would
+//!        start another one or replace the sprite until it is done. A save writes a snapshot, so the frames can keep
+//!        being edited, but a load replaces them when it finishes, so editing them waits for it too.
+//! \param description What the job is doing
+//!
+void MainWindow::displayFileJobStarted(const QString &description){
+    fileProgress->setFormat(description + " (%v of %m frames)");
+    fileProgress->setRange(0, 0);
+    fileProgress->show();
+    cancelFileButton->show();
+    setProjectActionsEnabled(false);
+    if (model->isLoading())
+        setFrameEditingEnabled(false);
+}
+
+//!
+//! \brief MainWindow::displayFileJobProgress Moves the progress bar on
+//! \param done The number of frames done so far
+//! \param total The number of frames, 0 while it is not known, which shows a busy bar
+//!
+void MainWindow::displayFileJobProgress(int done, int total){
+    fileProgress->setRange(0, total);
+    fileProgress->setValue(done);
+}
+
+//!
+//! \brief MainWindow::displayFileJobFinished Hides the progress bar once a load or save is done
+//! \param ok Whether it succeeded
+//! \param message Why it did not
+//!
+void MainWindow::displayFileJobFinished(bool ok, const QString &message){
+    fileProgress->hide();
+    cancelFileButton->hide();
+    setProjectActionsEnabled(true);
+    setFrameEditingEnabled(true);
+    if (!ok)
+        ui->statusbar->showMessage(message, 5000);
+}
+
+//!
+//! \brief MainWindow::setProjectActionsEnabled Enables or disables everything that starts a load or save or replaces
+//!        the whole sprite
+//! \param enabled Whether they can be used
+//!
+void MainWindow::setProjectActionsEnabled(bool enabled){
+    const QList<QWidget *> widgets = { ui->newButton, ui->saveButton, ui->openButton, ui->groupBox };
+    for (QWidget *widget : widgets)
+        widget->setEnabled(enabled);
+    const QList<QAction *> actions = { ui->actionNew, ui->actionOpen, ui->actionSave };
+    for (QAction *action : actions)
+        action->setEnabled(enabled);
+}
+
+//!
+//! \brief MainWindow::setFrameEditingEnabled Enables or disables drawing, moving between frames, and everything that
+//!        adds or removes frames. A load throws such changes away when it replaces the frames.
+//! \param enabled Whether they can be used
+//!
+void MainWindow::setFrameEditingEnabled(bool enabled){
+    const QList<QWidget *> widgets = { ui->frameEditor, ui->frameNumber, ui->addFrame, ui->deleteFrame };
+    for (QWidget *widget : widgets)
+        widget->setEnabled(enabled);
+    ui->actionDuplicate_Frame->setEnabled(enabled);
+    setHistoryActions(canUndo, canRedo);
+}
+
+//!
+//! \brief MainWindow::offerAutosaveRecovery Asks the user whether to bring back the frames from a session that did not
+//!        close normally. Frames that are not recovered, or cannot be, are kept in a backup of the journal.
+//!
+void MainWindow::offerAutosaveRecovery(){
+    if (!model->hasAutosaveToRecover())
+        return;
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this, tr("Recover Frames"),
+        tr("The editor did not close normally last time. Recover the frames from that session?"), QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+    QString error;
+    if (answer == QMessageBox::Yes && model->recoverAutosave(&error))
+        return;
+
+    // Never overwritten by the next checkpoint, in case the frames are wanted after all
+    QString backup = model->setAutosaveAside();
+    QString kept = backup.isEmpty() ? tr("The autosave journal was left where it is, and autosave is off until the editor is restarted.")
+                                    : tr("The autosave journal was kept as %1.").arg(backup);
+    if (answer == QMessageBox::Yes)
+        QMessageBox::warning(this, tr("Recover Frames"), tr("The frames could not be recovered: %1. %2").arg(error, kept));
+    else
+        ui->statusbar->showMessage(kept, 10000);
+}
+
+//!
+//! \brief MainWindow::displayAutosaveRecovered Tells the user the frames were brought back from the last session
+//! \param frameCount How many frames were recovered
+//!
+void MainWindow::displayAutosaveRecovered(int frameCount){
+    ui->statusbar->showMessage(tr("Recovered %1 frames from the last session").arg(frameCount), 10000);
+}
+
 //!
 //! \brief MainWindow::setPreviewFrame Changes the preview frame pixamp
-//! \param frame the frame to display
+//! \param frame the frame to display, already scaled by the model
 //!
-void MainWindow::setPreviewFrame(QPixmap frame){
-    QPixmap display = frame;
-    if(ui->scaleToggle->isChecked()) display = frame.scaled(ui->previewFrame->size(),Qt::KeepAspectRatio);
-    ui->previewFrame->setPixmap(display);
+void MainWindow::setPreviewFrame(const QPixmap &frame){
+    ui->previewFrame->setPixmap(frame);
+}
+
+//!
+//! \brief MainWindow::updatePreviewScale Tells the model what size to scale preview frames to
+//!
+void MainWindow::updatePreviewScale(){
+    QSize size = ui->scaleToggle->isChecked() ? ui->previewFrame->size() : QSize();
+    emit previewScaleChanged(size, ui->nearestToggle->isChecked());
+}
+
+//!
+//! \brief MainWindow::resizeEvent Rescales the preview frames if resizing the window resized the preview
+//! \param event The resize event
+//!
+void MainWindow::resizeEvent(QResizeEvent *event){
+    QMainWindow::resizeEvent(event);
+    updatePreviewScale();
 }
 
 //!
@@ -483,10 +749,11 @@ void MainWindow::actionSaveTriggered() {
     ui->actionShapes->setChecked(false);
     ui->secondaryToolBar->setVisible(false);
     emit activeTool("none");
-    fileName = QFileDialog::getSaveFileName(this, tr("Save File"), QDir::currentPath(), tr("Sprite Sheet Project (*.ssp)"));
+    fileName = QFileDialog::getSaveFileName(this, tr("Save File"), QDir::currentPath(), tr("Sprite Sheet Project (*.ssp);;Binary Sprite Sheet Project (*.sspb)"));
 
     // Save the file
     if (!fileName.isEmpty()) {
+        ui->frameEditor->unmapFile(fileName);
         emit saveFile(fileName);
         emit activeMirror(false);
         ui->actionMirror->setChecked(false);
@@ -509,7 +776,7 @@ void MainWindow::actionOpenTriggered() {
     emit activeTool("none");
 
     // Open the open dialog
-    fileName = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::currentPath(), tr("Sprite Sheet Project (*.ssp)"));
+    fileName = QFileDialog::getOpenFileName(this, tr("Open File"), QDir::currentPath(), tr("Sprite Sheet Project (*.ssp *.sspb)"));
 
     if (!fileName.isEmpty()) {
         // Load the file
@@ -531,3 +798,12 @@ void MainWindow::displayOpenImageSizeError()
 {
     QMessageBox::warning(this, tr("File Error"), tr("Unable to parse file. Try again."));
 }
+
+//!
+//! \brief MainWindow::displaySaveImageError Displays the error popup for a failed save
+//! \param message Why the sprite was not saved
+//!
+void MainWindow::displaySaveImageError(const QString &message)
+{
+    QMessageBox::warning(this, tr("File Error"), tr("The sprite was not saved: %1").arg(message));
+}
@@ -14,6 +14,8 @@
 #include <QColorDialog>
 #include <QButtonGroup>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QProgressBar>
 #include "ui_mainwindow.h"
 #include "QScreen"
 #include "QMessageBox"
@@ -29,6 +31,7 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(Model* model, QWidget *parent = nullptr);
     ~MainWindow();
+    void offerAutosaveRecovery();
 
     QCursor eraserCursor;
     QCursor fillCursor;
@@ -46,9 +49,12 @@ signals:
     void startNewProject(QString name, Model* model);
     void activeTool(QString toolName);
     void previewPlayed(QSpinBox* frameCount);
+    void previewStopped();
+    void previewScaleChanged(QSize size, bool nearest);
     void frameAdded(Model* model);
     void frameChanged(int frameNumber, Model* model);
     void frameDeleted(Model* model);
+    void frameDuplicated(Model* model);
     void activeMirror(bool active);
 
 private:
@@ -62,16 +68,32 @@ private:
     void addFrame();
     void changeFrame(int num);
     void deleteFrame();
+    void updatePreviewScale();
+    void duplicateFrame();
+    void setProjectActionsEnabled(bool enabled);
+    void setFrameEditingEnabled(bool enabled);
     QString previousTool = "brush";
+    bool canUndo = false;
+    bool canRedo = false;
+    QLabel *memoryUsage;
+    QTimer memoryTimer;
+    QProgressBar *fileProgress;
+    QPushButton *cancelFileButton;
 
 private slots:
     void actionEraserToggled(bool toggled);
     void actionBrushToggled(bool toggled);
     void actionFillAllToggled(bool toggled);
     void actionFillToggled(bool toggled);
+    void actionFillToleranceTriggered();
+    void actionBrushSizeTriggered();
+    void actionUndoMemoryLimitTriggered();
+    void actionLoadSaveThreadsTriggered();
+    void setHistoryActions(bool canUndo, bool canRedo);
     void actionEyedropToolToggled(bool toggled);
     void actionColorPickerToggled(bool toggled);
     void actionReadMeTriggered();
+    void actionSaveTraceTriggered();
     void actionNewTriggered();
     void actionSaveTriggered();
     void actionOpenTriggered();
@@ -85,7 +107,18 @@ private slots:
     void onButtonNewOk();
     void onButtonNewCancel();
     void onPreviewStart();
-    void setPreviewFrame(QPixmap frame);
+    void onPreviewStop();
+    void displayPreviewStats(double achievedFps, double jitterMs, qint64 droppedFrames);
+    void displayMemoryUsage();
+    void displayFileJobStarted(const QString &description);
+    void displayFileJobProgress(int done, int total);
+    void displayFileJobFinished(bool ok, const QString &message);
+    void displayAutosaveRecovered(int frameCount);
+    void setPreviewFrame(const QPixmap &frame);
     void displayOpenImageSizeError();
+    void displaySaveImageError(const QString &message);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
 };
 #endif // MAINWINDOW_H
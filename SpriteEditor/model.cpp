@@ -6,141 +6,343 @@
  */
 
 #include "model.h"
+#include "framepool.h"
+#include "trace.h"
+#include <QFileInfo>
+#include <QtConcurrent>
+
+// How often the progress of a load or save is reported, in milliseconds
+static const int fileProgressInterval = 50;
+
+// How often the frames are checkpointed into the autosave journal, in milliseconds
+static const int autosaveInterval = 10000;
 
 //!
 //! \brief Model::Model Constructor
 //! \param parent The parent object
 //!
-Model::Model(QObject *parent) : QObject{parent} {
-    size = 32;
+Model::Model(QObject *parent) : QObject{parent}, frames(32) {
+    compactSave = false;
+    previewLooping = false;
+    ioPool.setMaxThreadCount(QThread::idealThreadCount());
+    fileJob = FileJob::None;
+
+    connect(&fileWatcher, &QFutureWatcher<bool>::finished, this, &Model::finishFileJob);
+    connect(&fileProgressTimer, &QTimer::timeout, this, &Model::reportFileProgress);
+    connect(&decodeWatcher, &QFutureWatcher<bool>::finished, this, &Model::finishBackgroundDecode);
+    connect(&autosaveWatcher, &QFutureWatcher<bool>::finished, this, &Model::finishAutosave);
+    connect(&autosaveTimer, &QTimer::timeout, this, &Model::autosaveFrames);
+    connect(&previewClock, &PreviewClock::frameDue, this, &Model::showPreviewFrame);
+    connect(&previewClock, &PreviewClock::statsChanged, this, &Model::previewStats);
 }
 
 //!
-//! \brief Model::~Model Destructor
+//! \brief Model::~Model Destructor, stops any load or save still running. Closing normally leaves nothing to recover,
+//!        so the autosave journal is deleted.
 //!
 Model::~Model(){
+    fileProgress.cancel();
+    fileWatcher.waitForFinished();
+    stopBackgroundDecode();
+
+    autosaveTimer.stop();
+    autosaveWatcher.waitForFinished();
+    if (autosave)
+        autosave->remove();
 }
 
 //!
-//! \brief Model::LoadFile Opens a JSON sprite file and parses information into the Model class and its members
-//! \param filename The file to be opened (includes path)
+//! \brief Model::startAutosave Starts checkpointing the frames into an autosave journal every few seconds. If another
+//!        editor is already using the journal this one does not autosave. If an editor that did not close normally
+//!        left a journal, checkpointing waits until it has been recovered or set aside, so it is never overwritten.
+//! \param filename The journal file (includes path)
+//! \return Whether autosave was started
 //!
-void Model::loadFile(QString filename) {
-    // Open file
-    QFile file(filename);
-    if (file.open(QIODevice::ReadOnly)) {
-        // Get all contents
-        QString contents = file.readAll();
-        file.close();
-
-        QJsonParseError error;
-        QJsonDocument document = QJsonDocument::fromJson(contents.toUtf8(), &error);
-
-        QJsonObject jsonObject = document.object();
-
-        // Check for any errors
-        if (document["height"].toInt() != document["width"].toInt() || !jsonObject.contains("height") || !jsonObject.contains("width") || !jsonObject.contains("numberOfFrames") || !jsonObject.contains("frames") || error.error != QJsonParseError::NoError) {
-            emit loadImageError();
-            return;
-        }
-
-        // Prepare for new sprite
-        maps.clear();
-        items.clear();
-        painters.clear();
-
-        // Extract information
-        size = document["height"].toInt();
-
-        // Get frame data
-        QJsonObject frames = document["frames"].toObject();
-        for (int i = 0; i < document["numberOfFrames"].toInt(); i++) {
-            // Obtain the frame array
-            QJsonArray currFrame = frames["frame" + QString::number(i)].toArray();
-
-            QImage image(size, size, QImage::Format_RGBA8888);
-
-            // Loop through columns
-            for (int y = 0; y < size; y++) {
-                QJsonArray row = currFrame[y].toArray();
-
-                // Loop through rows
-                for (int x = 0; x < size; x++) {
-                    QJsonArray pixels = row[x].toArray();
-                    int r = pixels[0].toInt();
-                    int g = pixels[1].toInt();
-                    int b = pixels[2].toInt();
-                    int a = pixels[3].toInt();
-                    image.setPixelColor(x, y, QColor(r, g, b, a));
-                }
-            }
-
-            // Add parsed information
-            QPixmap *frame = new QPixmap(size, size);
-            *frame = QPixmap::fromImage(image);
-            maps.push_back(frame);
-            QPainter *painter = new QPainter(frame);
-            painters.push_back(painter);
-            QGraphicsPixmapItem *item = new QGraphicsPixmapItem(*frame);
-            items.push_back(item);
-        }
+bool Model::startAutosave(const QString &filename) {
+    // The lock is left behind by a crash, and taken over once its process is gone
+    autosaveLock = std::make_unique<QLockFile>(filename + ".lock");
+    if (!autosaveLock->tryLock(0)) {
+        autosaveLock.reset();
+        return false;
     }
 
-    // Signal to display the first frame of the sprite
+    autosave = std::make_unique<AutosaveJournal>(filename);
+    if (!hasAutosaveToRecover())
+        autosaveTimer.start(autosaveInterval);
+    return true;
+}
+
+//!
+//! \brief Model::hasAutosaveToRecover Checks whether an editor that did not close normally left a journal
+//! \return Whether there is a journal waiting to be recovered or set aside
+//!
+bool Model::hasAutosaveToRecover() const {
+    return autosave && !autosaveTimer.isActive() && QFile::exists(autosave->fileName());
+}
+
+//!
+//! \brief Model::recoverAutosave Replays the autosave journal left by an editor that did not close normally, putting
+//!        its last checkpoint in the frame store, and starts checkpointing. A journal that cannot be recovered is left
+//!        as it is, to be set aside with setAutosaveAside.
+//! \param error Set to the reason nothing could be recovered
+//! \return Whether frames were recovered
+//!
+bool Model::recoverAutosave(QString *error) {
+    if (!hasAutosaveToRecover())
+        return false;
+
+    FrameStore recovered;
+    if (!AutosaveJournal::recover(autosave->fileName(), recovered, error))
+        return false;
+
+    frames.swap(recovered);
     emit loadFrame(1);
+    startBackgroundDecode();
+    autosaveTimer.start(autosaveInterval);
+    emit autosaveRecovered(frames.frameCount());
+    return true;
+}
+
+//!
+//! \brief Model::setAutosaveAside Keeps the journal left by an editor that did not close normally under its backup
+//!        name, for when it is not recovered, and starts checkpointing into a fresh one. If it cannot be renamed this
+//!        editor does not autosave, so the journal is still there next time.
+//! \return The journal's backup name, or an empty string if it was not set aside
+//!
+QString Model::setAutosaveAside() {
+    if (!hasAutosaveToRecover())
+        return QString();
+
+    if (!autosave->setAside()) {
+        autosave.reset();
+        autosaveLock.reset();
+        return QString();
+    }
+    autosaveTimer.start(autosaveInterval);
+    return autosave->backupFileName();
+}
+
+//!
+//! \brief Model::autosaveFrames Checkpoints the frames into the autosave journal on a worker thread. All this thread
+//!        does is compare the frame versions with the last checkpoint and take a snapshot, which copies no pixels, so
+//!        painting is never held up. Frames are written to the journal only if they were drawn on since.
+//!
+void Model::autosaveFrames() {
+    TraceScope trace("Model::autosaveFrames");
+    if (!autosave || autosaveWatcher.isRunning())
+        return;
+
+    // Every write to a frame gives it a new version, so nothing changed if the versions are the same
+    vector<quint64> versions(frames.frameCount());
+    for (int i = 0; i < frames.frameCount(); i++)
+        versions[i] = frames.version(i);
+    if (versions == autosavedVersions)
+        return;
+    autosavedVersions = std::move(versions);
+
+    // The snapshot is dropped back on this thread once the checkpoint is written
+    autosaveSnapshot = frames.snapshot();
+    const FrameStore *snapshot = autosaveSnapshot.get();
+    AutosaveJournal *journal = autosave.get();
+    autosaveWatcher.setFuture(QtConcurrent::run([journal, snapshot] {
+        TraceScope trace("AutosaveJournal::checkpoint");
+        return journal->checkpoint(*snapshot);
+    }));
 }
 
 //!
-//! \brief Model::saveFile Saves the sprite using JSON format
+//! \brief Model::finishAutosave Drops the snapshot a checkpoint was written from
+//!
+void Model::finishAutosave() {
+    autosaveSnapshot.reset();
+
+    // A failed checkpoint is tried again next time
+    if (!autosaveWatcher.result())
+        autosavedVersions.clear();
+}
+
+//!
+//! \brief Model::LoadFile Starts opening a JSON (.ssp) or binary (.sspb) sprite file in the background. The file is
+//!        read into a separate store, which replaces the frame store in one step once the whole file has been read.
+//! \param filename The file to be opened (includes path)
+//!
+void Model::loadFile(QString filename) {
+    waitForFileJob();
+    stopBackgroundDecode();
+
+    // Frames are decoded as they are needed, so even a long animation shows its first frame at once
+    fileFrames = std::make_unique<FrameStore>();
+    FrameStore *loaded = fileFrames.get();
+    startFileJob(FileJob::Load, tr("Opening %1").arg(QFileInfo(filename).fileName()), [this, filename, loaded] {
+        TraceScope trace("Model::loadFile");
+        return ProjectFile::loadLazily(filename, *loaded, &fileError, &fileProgress);
+    });
+}
+
+//!
+//! \brief Model::saveFile Starts saving the sprite in the background, using JSON format streamed to the file one frame
+//!        at a time, or as raw scanlines when the file name ends in .sspb. What is saved is a snapshot of the frames
+//!        as they are now, so they can keep being edited while the save runs.
 //! \param filename The file to be opened (includes path)
 //!
 void Model::saveFile(QString filename) {
-    // Create json object to store data
-    QJsonObject json;
-
-    // Add parameters
-    json["height"] = size;
-    json["width"] = size;
-    json["numberOfFrames"] = (int)maps.size();
-
-    // Add frames
-    QJsonObject frames;
-    // Loop through each frame in maps
-    for (int i = 0; i < (int)maps.size(); i++) {
-        QJsonArray currframe;
-
-        // Loop through each column in the image
-        for (int y = 0; y < size; y++) {
-            QJsonArray row;
-            // Loop through each row
-            for (int x = 0; x < size; x ++) {
-                // Convert QPixmap to a QImage to get QColor
-                QColor color = maps[i]->toImage().pixelColor(x, y);
-                int r = color.red();
-                int g = color.green();
-                int b = color.blue();
-                int a = color.alpha();
-
-                // Store QColor of current pixel in row
-                QJsonArray rgba = { r, g, b, a };
-                row.append(rgba);
-            }
-            // Add row to the frame
-            currframe.append(row);
-        }
-        // Add frame to the array
-        frames["frame" + QString::number(i)] = currframe;
-    }
-    // Add all frames to the json object
-    json["frames"] = frames;
-
-    // Write to file
-    QJsonDocument document(json);
-    QFile file(filename);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(document.toJson());
-        file.close();
+    waitForFileJob();
+
+    // The snapshot is dropped back on this thread once the save is done
+    fileSnapshot = frames.snapshot();
+    const FrameStore *snapshot = fileSnapshot.get();
+    bool compact = compactSave;
+    QThreadPool *pool = framePool();
+    startFileJob(FileJob::Save, tr("Saving %1").arg(QFileInfo(filename).fileName()), [this, filename, snapshot, compact, pool] {
+        TraceScope trace("Model::saveFile");
+        return ProjectFile::save(*snapshot, filename, compact, pool, &fileProgress, &fileError);
+    });
+}
+
+//!
+//! \brief Model::startFileJob Runs a load or save on a background thread and starts reporting its progress
+//! \param job Which kind of job it is
+//! \param description What the job is doing, to show the user
+//! \param work The job, returning whether it succeeded
+//!
+void Model::startFileJob(FileJob job, const QString &description, const std::function<bool()> &work) {
+    fileJob = job;
+    fileProgress.reset();
+    fileError.clear();
+    fileWatcher.setFuture(QtConcurrent::run(work));
+    fileProgressTimer.start(fileProgressInterval);
+    emit fileJobStarted(description);
+}
+
+//!
+//! \brief Model::finishFileJob Takes the result of a finished load or save. A loaded sprite is swapped into the frame
+//!        store here, on the thread that owns it, and the store it replaces or the snapshot that was saved is freed.
+//!
+void Model::finishFileJob() {
+    if (fileJob == FileJob::None || !fileWatcher.isFinished())
+        return;
+
+    FileJob job = fileJob;
+    fileJob = FileJob::None;
+    fileProgressTimer.stop();
+    reportFileProgress();
+
+    bool ok = fileWatcher.result();
+    bool cancelled = !ok && fileProgress.isCancelled();
+    QString message;
+    if (cancelled)
+        message = tr("Cancelled");
+    else if (!ok)
+        message = fileError.isEmpty() ? tr("Unable to write the file") : fileError;
+
+    std::unique_ptr<FrameStore> finished = std::move(fileFrames);
+    fileSnapshot.reset();
+    int oldSize = frames.size();
+    if (job == FileJob::Load && ok) {
+        frames.swap(*finished);
+        // Signal to display the first frame of the sprite
+        emit loadFrame(1);
+        startBackgroundDecode();
+    } else if (job == FileJob::Load && !cancelled) {
+        // A bad file leaves the current sprite alone
+        emit loadImageError();
+    } else if (job == FileJob::Save && ok) {
+        // Saving over the file undecoded frames were referenced from makes the next checkpoint write them out
+        autosavedVersions.clear();
+    } else if (job == FileJob::Save && !cancelled) {
+        // A failed save leaves the old file as it was
+        emit saveImageError(message);
     }
+    finished.reset();
+
+    // Pooled blocks of the old canvas size are no use to the new one
+    if (frames.size() != oldSize)
+        FramePool::trim();
+
+    emit fileJobFinished(ok, message);
+}
+
+//!
+//! \brief Model::startBackgroundDecode Decodes the frames of the sprite just opened that have not been shown yet, on
+//!        the load and save threads, so flipping through them later does not stop to decode each one. The snapshot
+//!        only shares the frames, so a frame drawn on before it is decoded just gets its own copy.
+//!
+void Model::startBackgroundDecode() {
+    decodeProgress.reset();
+    decodeSnapshot = frames.snapshot();
+    const FrameStore *snapshot = decodeSnapshot.get();
+    QThreadPool *pool = framePool();
+    decodeWatcher.setFuture(QtConcurrent::run([this, snapshot, pool] {
+        TraceScope trace("Model::decodeFrames");
+        return ProjectFile::decodeAll(*snapshot, pool, &decodeProgress);
+    }));
+}
+
+//!
+//! \brief Model::finishBackgroundDecode Drops the snapshot the frames were decoded from, back on the thread that owns
+//!        the frame store, so the store never writes in place to a frame the decode could still be reading
+//!
+void Model::finishBackgroundDecode() {
+    decodeSnapshot.reset();
+}
+
+//!
+//! \brief Model::stopBackgroundDecode Stops decoding the frames of the last sprite opened, leaving the rest to be
+//!        decoded as they are needed
+//!
+void Model::stopBackgroundDecode() {
+    decodeProgress.cancel();
+    decodeWatcher.waitForFinished();
+    finishBackgroundDecode();
+}
+
+//!
+//! \brief Model::cancelFileJob Asks the running load or save to stop. A cancelled load leaves the current sprite
+//!        alone and a cancelled save leaves the old file as it was.
+//!
+void Model::cancelFileJob() {
+    if (fileJob != FileJob::None)
+        fileProgress.cancel();
+}
+
+//!
+//! \brief Model::waitForFileJob Blocks until the running load or save is done and takes its result, so the next job
+//!        starts from the frames the last one left
+//!
+void Model::waitForFileJob() {
+    fileWatcher.waitForFinished();
+    finishFileJob();
+}
+
+//!
+//! \brief Model::reportFileProgress Reports how many frames the running load or save has got through
+//!
+void Model::reportFileProgress() {
+    emit fileJobProgress(fileProgress.done(), fileProgress.total());
+}
+
+//!
+//! \brief Model::setCompactSave Toggles writing saved files without indentation
+//! \param compact Whether saved files should be compact
+//!
+void Model::setCompactSave(bool compact) {
+    compactSave = compact;
+}
+
+//!
+//! \brief Model::setIoThreadCount Sets how many threads frames are encoded and decoded on when saving and loading
+//! \param count The number of threads, 1 or less does all the work on the calling thread
+//!
+void Model::setIoThreadCount(int count) {
+    ioPool.setMaxThreadCount(qMax(1, count));
+}
+
+//!
+//! \brief Model::framePool Gets the pool to spread per-frame work over
+//! \return The pool, or nullptr when only one thread is allowed
+//!
+QThreadPool *Model::framePool() {
+    return ioPool.maxThreadCount() > 1 ? &ioPool : nullptr;
 }
 
 //!
@@ -152,21 +354,64 @@ void Model::toggleLoop(bool toggle){
 }
 
 //!
-//! \brief Model::playPreview A recursive that plays each frame the user created in an animation format
+//! \brief Model::playPreview Plays the frames the user created as an animation, starting again from the first frame
+//!        if it is already playing
 //! \param fpsStorage The object that stores the fps
 //!
 void Model::playPreview(QSpinBox* fpsStorage){
-    // Obtain fps value from QSpinBox
-    int fps = fpsStorage->value();
+    previewClock.start(fpsStorage->value());
+}
+
+//!
+//! \brief Model::pausePreview Pauses or resumes the preview on the frame it is showing
+//! \param paused Whether to pause
+//!
+void Model::pausePreview(bool paused){
+    previewClock.setPaused(paused);
+}
+
+//!
+//! \brief Model::stopPreview Stops the preview and clears it
+//!
+void Model::stopPreview(){
+    previewClock.stop();
+    emit setPreviewFrame(QPixmap());
+}
+
+//!
+//! \brief Model::setPreviewFps Changes the preview's frame rate, while it plays if it is playing
+//! \param fps The number of frames per second
+//!
+void Model::setPreviewFps(int fps){
+    previewClock.setFps(fps);
+}
+
+//!
+//! \brief Model::setPreviewScale Sets how preview frames are scaled, they are scaled again the next time they are shown
+//! \param size The size to scale frames to, or an invalid size to show them at their actual size
+//! \param nearest Whether to scale by repeating pixels instead of smoothing them
+//!
+void Model::setPreviewScale(QSize size, bool nearest){
+    previewCache.setScale(size, nearest);
+}
+
+//!
+//! \brief Model::showPreviewFrame Shows the frame the preview clock says is due
+//! \param frame The number of frames since the preview started
+//!
+void Model::showPreviewFrame(qint64 frame){
+    TraceScope trace("Model::showPreviewFrame");
 
-    // Loop through each frame in maps and display it
-    for(int i = 0; i < (int)maps.size(); i++){
-        QTimer::singleShot((i * (1000/fps)) , this, [=](){emit setPreviewFrame(*maps[i]);});
+    // Frames can be added and deleted while the preview plays, so wrap around the current count
+    int frameCount = frames.frameCount();
+    if(frameCount == 0 || (frame >= frameCount && !previewLooping)){
+        stopPreview();
+        return;
     }
-    QPixmap empty;
+    // Already scaled unless the frame was drawn on since it was last shown
+    emit setPreviewFrame(previewCache.frame(frames, frame % frameCount));
 
-    if(previewLooping)
-        QTimer::singleShot((maps.size() * (1000/fps)) , this, [=](){playPreview(fpsStorage);});
-    else
-        QTimer::singleShot((maps.size() * (1000/fps)) , this, [=](){emit setPreviewFrame(empty);});
+    // Scale the frame after it in the background if that one was drawn on
+    if(frame + 1 < frameCount || previewLooping)
+        previewCache.prepare(frames, (frame + 1) % frameCount);
 }
@@ -8,22 +8,26 @@
 #ifndef MODEL_H
 #define MODEL_H
 
-#include "qgraphicsitem.h"
 #include "qspinbox.h"
+#include "autosavejournal.h"
+#include "fileprogress.h"
+#include "framestore.h"
+#include "previewcache.h"
+#include "previewclock.h"
+#include "projectfile.h"
 #include <QObject>
 #include <qpixmap.h>
 #include <QMap>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonDocument>
 #include <QFile>
+#include <QFutureWatcher>
+#include <QLockFile>
 #include <QMessageBox>
-#include <QPainter>
+#include <QThread>
+#include <QThreadPool>
 #include <QTimer>
+#include <functional>
 #include <iostream>
-#include <vector>
-
-using std::vector;
+#include <memory>
 
 class Model : public QObject
 {
@@ -32,24 +36,79 @@ public:
     explicit Model(QObject *parent = nullptr);
     ~Model();
 
-    vector<QPixmap *> maps;
-    vector<QGraphicsPixmapItem *> items;
-    vector<QPainter *> painters;
-    int size;
+    FrameStore frames;
     void saveFile(QString filename);
     void loadFile(QString filename);
+    bool isFileJobRunning() const { return fileJob != FileJob::None; }
+    bool isLoading() const { return fileJob == FileJob::Load; }
+    int ioThreadCount() const { return ioPool.maxThreadCount(); }
+    void waitForFileJob();
+    bool startAutosave(const QString &filename);
+    bool hasAutosaveToRecover() const;
+    bool recoverAutosave(QString *error = nullptr);
+    QString setAutosaveAside();
 
 signals:
-    void setPreviewFrame(QPixmap frame);
+    void setPreviewFrame(const QPixmap &frame);
     void loadImageError();
+    void saveImageError(const QString &message);
     void loadFrame(int pos);
+    void previewStats(double achievedFps, double jitterMs, qint64 droppedFrames);
+    void fileJobStarted(const QString &description);
+    void fileJobProgress(int done, int total);
+    void fileJobFinished(bool ok, const QString &message);
+    void autosaveRecovered(int frameCount);
 
 public slots:
     void playPreview(QSpinBox* frameCount);
+    void pausePreview(bool paused);
+    void stopPreview();
+    void setPreviewFps(int fps);
+    void setPreviewScale(QSize size, bool nearest);
     void toggleLoop(bool toggle);
+    void setCompactSave(bool compact);
+    void setIoThreadCount(int count);
+    void cancelFileJob();
 
 private:
     bool previewLooping;
+    PreviewClock previewClock;
+    PreviewCache previewCache;
+    bool compactSave;
+    QThreadPool ioPool;
+    QThreadPool *framePool();
+    void showPreviewFrame(qint64 frame);
+
+    //!
+    //! \brief FileJob The load or save running in the background, only one runs at a time
+    //!
+    enum class FileJob { None, Load, Save };
+    FileJob fileJob;
+    QFutureWatcher<bool> fileWatcher;
+    FileProgress fileProgress;
+    QTimer fileProgressTimer;
+    std::unique_ptr<FrameStore> fileFrames;
+    FrameSnapshot fileSnapshot;
+    QString fileError;
+    void startFileJob(FileJob job, const QString &description, const std::function<bool()> &work);
+    void finishFileJob();
+    void reportFileProgress();
+
+    QFutureWatcher<bool> decodeWatcher;
+    FileProgress decodeProgress;
+    FrameSnapshot decodeSnapshot;
+    void startBackgroundDecode();
+    void finishBackgroundDecode();
+    void stopBackgroundDecode();
+
+    std::unique_ptr<QLockFile> autosaveLock;
+    std::unique_ptr<AutosaveJournal> autosave;
+    QTimer autosaveTimer;
+    QFutureWatcher<bool> autosaveWatcher;
+    FrameSnapshot autosaveSnapshot;
+    vector<quint64> autosavedVersions;
+    void autosaveFrames();
+    void finishAutosave();
 };
 
 #endif // MODEL_H
@@ -0,0 +1,419 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "pixelkernels.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// SSE2 is part of every x86-64 target, AVX2 is compiled in separately and picked at run time on GCC and Clang
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PIXELKERNELS_SSE2
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PIXELKERNELS_AVX2 __attribute__((target("avx2")))
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define PIXELKERNELS_AVX2
+#endif
+
+//!
+//! \brief colorMatches Checks whether a pixel is within the tolerance of a color
+//!
+static inline bool colorMatches(Pixel pixel, Pixel target, int tolerance) {
+    if (tolerance <= 0)
+        return pixel == target;
+
+    for (int channel = 0; channel < 4; channel++) {
+        if (std::abs(pixelChannel(pixel, channel) - pixelChannel(target, channel)) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+//!
+//! \brief PixelKernels::floodFill Scanline flood fill, see floodRegion
+//! \param bits The frame's pixels
+//! \param size The width and height of the frame
+//! \param seed The pixel to start from, its color is the one replaced
+//! \param replacement The color to fill with
+//! \param options Connectivity and color tolerance
+//! \return The bounding box of every pixel that was filled, empty if nothing changed
+//!
+QRect PixelKernels::floodFill(Pixel *bits, int size, QPoint seed, Pixel replacement, const FillOptions &options) {
+    vector<Span> spans;
+    QRect region = floodRegion(bits, size, seed, replacement, options, spans);
+    for (const Span &span : spans) {
+        Pixel *line = bits + qsizetype(span.y) * size;
+        std::fill(line + span.left, line + span.right + 1, replacement);
+    }
+    return region;
+}
+
+//!
+//! \brief PixelKernels::floodRegion Finds the pixels a flood fill would fill without writing any of them, so what is
+//!        about to change can be saved first. Each step takes a whole horizontal run and then queues one seed for
+//!        each matching run touching it in the rows above and below, so the explicit stack stays small and no
+//!        recursion is needed however large the region is. Runs already taken are remembered in a scratch mask.
+//! \param bits The frame's pixels
+//! \param size The width and height of the frame
+//! \param seed The pixel to start from, its color is the one replaced
+//! \param replacement The color to fill with, nothing is filled if it is the seed's color and there is no tolerance
+//! \param options Connectivity and color tolerance
+//! \param spans Where the runs to fill are added
+//! \return The bounding box of the runs, empty if nothing would change
+//!
+QRect PixelKernels::floodRegion(const Pixel *bits, int size, QPoint seed, Pixel replacement, const FillOptions &options, vector<Span> &spans) {
+    if (seed.x() < 0 || seed.y() < 0 || seed.x() >= size || seed.y() >= size)
+        return QRect();
+
+    Pixel target = bits[qsizetype(seed.y()) * size + seed.x()];
+    int tolerance = options.tolerance;
+    if (tolerance <= 0 && target == replacement)
+        return QRect();
+
+    vector<quint8> filled(qsizetype(size) * size);
+    auto inside = [&](int x, int y) {
+        qsizetype index = qsizetype(y) * size + x;
+        return !filled[index] && colorMatches(bits[index], target, tolerance);
+    };
+
+    int reach = options.diagonal ? 1 : 0;
+    int left = size, top = size, right = -1, bottom = -1;
+    vector<QPoint> stack;
+    stack.push_back(seed);
+
+    while (!stack.empty()) {
+        QPoint point = stack.back();
+        stack.pop_back();
+
+        int y = point.y();
+        if (!inside(point.x(), y))
+            continue;
+
+        // Grow the run as far left and right as it matches, then take it
+        int runLeft = point.x();
+        int runRight = point.x();
+        while (runLeft > 0 && inside(runLeft - 1, y)) runLeft--;
+        while (runRight < size - 1 && inside(runRight + 1, y)) runRight++;
+
+        spans.push_back(Span { y, runLeft, runRight });
+        std::memset(filled.data() + qsizetype(y) * size + runLeft, 1, runRight - runLeft + 1);
+
+        left = qMin(left, runLeft);
+        right = qMax(right, runRight);
+        top = qMin(top, y);
+        bottom = qMax(bottom, y);
+
+        // Queue the start of every matching run in the neighbouring rows
+        int from = qMax(0, runLeft - reach);
+        int to = qMin(size - 1, runRight + reach);
+        for (int nextY = y - 1; nextY <= y + 1; nextY += 2) {
+            if (nextY < 0 || nextY >= size)
+                continue;
+
+            bool inRun = false;
+            for (int x = from; x <= to; x++) {
+                bool matches = inside(x, nextY);
+                if (matches && !inRun) stack.push_back(QPoint(x, nextY));
+                inRun = matches;
+            }
+        }
+    }
+
+    if (right < 0)
+        return QRect();
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+//!
+//! \brief PixelKernels::lineSpans Rasterizes a line with Bresenham's algorithm, both ends included. Consecutive pixels
+//!        on the same row are merged into one span, so a shallow line comes out as a few long runs.
+//! \param from The first pixel
+//! \param to The last pixel
+//! \param spans Where the line's runs are added, top to bottom or bottom to top along the line
+//!
+void PixelKernels::lineSpans(QPoint from, QPoint to, vector<Span> &spans) {
+    int dx = std::abs(to.x() - from.x());
+    int dy = -std::abs(to.y() - from.y());
+    int stepX = from.x() < to.x() ? 1 : -1;
+    int stepY = from.y() < to.y() ? 1 : -1;
+    int error = dx + dy;
+
+    int x = from.x();
+    int y = from.y();
+    Span span { y, x, x };
+    while (x != to.x() || y != to.y()) {
+        int error2 = 2 * error;
+        if (error2 >= dy) {
+            error += dy;
+            x += stepX;
+        }
+        if (error2 <= dx) {
+            error += dx;
+            y += stepY;
+        }
+
+        if (y != span.y) {
+            spans.push_back(span);
+            span = Span { y, x, x };
+        } else {
+            span.left = qMin(span.left, x);
+            span.right = qMax(span.right, x);
+        }
+    }
+    spans.push_back(span);
+}
+
+//!
+//! \brief replaceColorScalar Replaces pixels one at a time, used for the tail of a buffer and on CPUs without SSE2
+//!
+static qsizetype replaceColorScalar(Pixel *bits, qsizetype count, Pixel target, Pixel replacement) {
+    qsizetype replaced = 0;
+    for (qsizetype i = 0; i < count; i++) {
+        if (bits[i] == target) {
+            bits[i] = replacement;
+            replaced++;
+        }
+    }
+    return replaced;
+}
+
+#ifdef PIXELKERNELS_SSE2
+//!
+//! \brief replaceColorSse2 Compares and replaces four pixels at a time
+//!
+static qsizetype replaceColorSse2(Pixel *bits, qsizetype count, Pixel target, Pixel replacement) {
+    const __m128i targets = _mm_set1_epi32((int)target);
+    const __m128i replacements = _mm_set1_epi32((int)replacement);
+    qsizetype replaced = 0;
+    qsizetype i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i *block = reinterpret_cast<__m128i *>(bits + i);
+        __m128i pixels = _mm_loadu_si128(block);
+        __m128i matches = _mm_cmpeq_epi32(pixels, targets);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(matches));
+
+        // Blocks with nothing to replace are not written, which keeps copy-on-write pages shared
+        if (mask) {
+            _mm_storeu_si128(block, _mm_or_si128(_mm_and_si128(matches, replacements), _mm_andnot_si128(matches, pixels)));
+            replaced += qPopulationCount(quint32(mask));
+        }
+    }
+    return replaced + replaceColorScalar(bits + i, count - i, target, replacement);
+}
+#endif
+
+#ifdef PIXELKERNELS_AVX2
+//!
+//! \brief replaceColorAvx2 Compares and replaces eight pixels at a time
+//!
+PIXELKERNELS_AVX2 static qsizetype replaceColorAvx2(Pixel *bits, qsizetype count, Pixel target, Pixel replacement) {
+    const __m256i targets = _mm256_set1_epi32((int)target);
+    const __m256i replacements = _mm256_set1_epi32((int)replacement);
+    qsizetype replaced = 0;
+    qsizetype i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i *block = reinterpret_cast<__m256i *>(bits + i);
+        __m256i pixels = _mm256_loadu_si256(block);
+        __m256i matches = _mm256_cmpeq_epi32(pixels, targets);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(matches));
+
+        if (mask) {
+            _mm256_storeu_si256(block, _mm256_blendv_epi8(pixels, replacements, matches));
+            replaced += qPopulationCount(quint32(mask));
+        }
+    }
+    return replaced + replaceColorScalar(bits + i, count - i, target, replacement);
+}
+
+//!
+//! \brief hasAvx2 Checks once whether the CPU running the editor supports AVX2
+//!
+static bool hasAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return true;
+#endif
+}
+#endif
+
+//!
+//! \brief PixelKernels::replaceColor Replaces every pixel of one exact color with another, using the widest vector
+//!        instructions the CPU has
+//! \param bits The pixels to recolor
+//! \param count How many pixels there are
+//! \param target The color to replace
+//! \param replacement The color to replace it with
+//! \return The number of pixels replaced
+//!
+qsizetype PixelKernels::replaceColor(Pixel *bits, qsizetype count, Pixel target, Pixel replacement) {
+    if (target == replacement)
+        return 0;
+
+#ifdef PIXELKERNELS_AVX2
+    if (hasAvx2())
+        return replaceColorAvx2(bits, count, target, replacement);
+#endif
+#ifdef PIXELKERNELS_SSE2
+    return replaceColorSse2(bits, count, target, replacement);
+#else
+    return replaceColorScalar(bits, count, target, replacement);
+#endif
+}
+
+//!
+//! \brief rowHasColor Checks whether any pixel of a row is a color, comparing four at a time where SSE2 is available
+//!
+static inline bool rowHasColor(const Pixel *row, int width, Pixel target) {
+    int x = 0;
+#ifdef PIXELKERNELS_SSE2
+    const __m128i targets = _mm_set1_epi32((int)target);
+    __m128i matches = _mm_setzero_si128();
+    for (; x + 4 <= width; x += 4)
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)), targets));
+    if (_mm_movemask_epi8(matches))
+        return true;
+#endif
+    for (; x < width; x++) {
+        if (row[x] == target)
+            return true;
+    }
+    return false;
+}
+
+//!
+//! \brief PixelKernels::colorBounds Finds the smallest rectangle holding every pixel of a color, without writing to
+//!        the frame, so a recolor can skip frames and rows without the color
+//! \param bits The frame's pixels
+//! \param size The width and height of the frame
+//! \param target The color to look for
+//! \return The rectangle, empty if the color is not in the frame
+//!
+QRect PixelKernels::colorBounds(const Pixel *bits, int size, Pixel target) {
+    int left = size;
+    int right = -1;
+    int top = -1;
+    int bottom = -1;
+
+    for (int y = 0; y < size; y++) {
+        const Pixel *row = bits + qsizetype(y) * size;
+        if (!rowHasColor(row, size, target))
+            continue;
+        if (top < 0)
+            top = y;
+        bottom = y;
+
+        // Only the columns outside the bounds so far can widen them
+        for (int x = 0; x < left; x++) {
+            if (row[x] == target) {
+                left = x;
+                break;
+            }
+        }
+        for (int x = size - 1; x > right; x--) {
+            if (row[x] == target) {
+                right = x;
+                break;
+            }
+        }
+    }
+    return top < 0 ? QRect() : QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+//!
+//! \brief expandRow Writes each pixel of a row Factor times side by side. The common factors are unrolled at compile
+//!        time and stored a vector at a time.
+//! \param source The first source pixel
+//! \param width How many source pixels to expand
+//! \param target Where the first expanded pixel goes, width * Factor pixels are written
+//!
+template <int Factor>
+static inline void expandRow(const Pixel *source, int width, Pixel *target) {
+    int x = 0;
+#ifdef PIXELKERNELS_SSE2
+    if (Factor == 2) {
+        // Interleaving a block with itself doubles each of its four pixels
+        for (; x + 4 <= width; x += 4, target += 8) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(target), _mm_unpacklo_epi32(pixels, pixels));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(target + 4), _mm_unpackhi_epi32(pixels, pixels));
+        }
+    } else if (Factor % 4 == 0) {
+        // Broadcast each pixel into a block and store it Factor / 4 times
+        for (; x < width; x++) {
+            __m128i pixel = _mm_set1_epi32((int)source[x]);
+            for (int i = 0; i < Factor; i += 4, target += 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(target), pixel);
+        }
+    }
+#endif
+    for (; x < width; x++, target += Factor)
+        std::fill_n(target, Factor, source[x]);
+}
+
+//!
+//! \brief upscaleRect Nearest neighbour scales part of a frame by a fixed factor. Each source row is expanded once
+//!        and the result is copied down to the Factor - 1 rows under it.
+//!
+template <int Factor>
+static void upscaleRect(const Pixel *bits, int size, const QRect &rect, Pixel *scaled, qsizetype scaledStride) {
+    qsizetype rowBytes = qsizetype(rect.width()) * Factor * sizeof(Pixel);
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        Pixel *target = scaled + qsizetype(y) * Factor * scaledStride + qsizetype(rect.left()) * Factor;
+        expandRow<Factor>(bits + qsizetype(y) * size + rect.left(), rect.width(), target);
+        for (int i = 1; i < Factor; i++)
+            std::memcpy(target + i * scaledStride, target, rowBytes);
+    }
+}
+
+//!
+//! \brief upscaleRectAnyFactor Nearest neighbour scales part of a frame by a factor without a specialization
+//!
+static void upscaleRectAnyFactor(const Pixel *bits, int size, const QRect &rect, int factor, Pixel *scaled, qsizetype scaledStride) {
+    qsizetype rowBytes = qsizetype(rect.width()) * factor * sizeof(Pixel);
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        Pixel *target = scaled + qsizetype(y) * factor * scaledStride + qsizetype(rect.left()) * factor;
+        const Pixel *source = bits + qsizetype(y) * size + rect.left();
+        for (int x = 0; x < rect.width(); x++)
+            std::fill_n(target + qsizetype(x) * factor, factor, source[x]);
+        for (int i = 1; i < factor; i++)
+            std::memcpy(target + i * scaledStride, target, rowBytes);
+    }
+}
+
+//!
+//! \brief PixelKernels::upscale Nearest neighbour scales part of a frame up by a whole number factor into a larger
+//!        buffer, so only pixels that changed need to be redrawn in the view. Every canvas size from 16 to 256 divides
+//!        the 512 pixel view, and each of those factors has its own unrolled version.
+//! \param bits The frame's pixels
+//! \param size The width and height of the frame
+//! \param rect The source pixels to scale, clipped to the frame
+//! \param factor How many times larger the scaled buffer is, at least 1
+//! \param scaled The scaled buffer, at least size * factor pixels square
+//! \param scaledStride The number of pixels in one row of the scaled buffer
+//!
+void PixelKernels::upscale(const Pixel *bits, int size, const QRect &rect, int factor, Pixel *scaled, qsizetype scaledStride) {
+    QRect source = rect.intersected(QRect(0, 0, size, size));
+    if (source.isEmpty() || factor < 1)
+        return;
+
+    switch (factor) {
+    case 1: upscaleRect<1>(bits, size, source, scaled, scaledStride); break;
+    case 2: upscaleRect<2>(bits, size, source, scaled, scaledStride); break;
+    case 4: upscaleRect<4>(bits, size, source, scaled, scaledStride); break;
+    case 8: upscaleRect<8>(bits, size, source, scaled, scaledStride); break;
+    case 16: upscaleRect<16>(bits, size, source, scaled, scaledStride); break;
+    case 32: upscaleRect<32>(bits, size, source, scaled, scaledStride); break;
+    default: upscaleRectAnyFactor(bits, size, source, factor, scaled, scaledStride); break;
+    }
+}
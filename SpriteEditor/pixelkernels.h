@@ -0,0 +1,47 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef PIXELKERNELS_H
+#define PIXELKERNELS_H
+
+#include "framestore.h"
+#include <QPoint>
+#include <QRect>
+
+//!
+//! \brief PixelKernels The tool algorithms, written against a raw size * size frame buffer so they never go through
+//!        QImage or QPainter and can be benchmarked without the editor.
+//!
+namespace PixelKernels {
+
+//!
+//! \brief FillOptions How far a flood fill spreads
+//!
+struct FillOptions {
+    // Also spread to the four diagonal neighbours
+    bool diagonal = false;
+    // The largest difference in any one channel from the seed color that still gets filled
+    int tolerance = 0;
+};
+
+//!
+//! \brief Span A horizontal run of pixels, from left to right inclusive
+//!
+struct Span {
+    int y;
+    int left;
+    int right;
+};
+
+QRect floodFill(Pixel *bits, int size, QPoint seed, Pixel replacement, const FillOptions &options = FillOptions());
+QRect floodRegion(const Pixel *bits, int size, QPoint seed, Pixel replacement, const FillOptions &options, vector<Span> &spans);
+void lineSpans(QPoint from, QPoint to, vector<Span> &spans);
+qsizetype replaceColor(Pixel *bits, qsizetype count, Pixel target, Pixel replacement);
+QRect colorBounds(const Pixel *bits, int size, Pixel target);
+void upscale(const Pixel *bits, int size, const QRect &rect, int factor, Pixel *scaled, qsizetype scaledStride);
+
+}
+
+#endif // PIXELKERNELS_H
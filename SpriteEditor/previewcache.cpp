@@ -0,0 +1,150 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "previewcache.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+//!
+//! \brief PreviewCache::PreviewCache Constructor, frames are shown at their actual size until a scale is set
+//!
+PreviewCache::PreviewCache() {
+    nearest = true;
+    QObject::connect(&pendingWatcher, &QFutureWatcher<QImage>::finished, &pendingWatcher, [this] { releaseSnapshot(); });
+}
+
+//!
+//! \brief PreviewCache::~PreviewCache Destructor, waits for a frame still being scaled so no worker outlives the cache
+//!
+PreviewCache::~PreviewCache() {
+    pending.image.waitForFinished();
+}
+
+//!
+//! \brief PreviewCache::setScale Sets how frames are scaled, throwing away the cached frames if it changed
+//! \param size The size to scale frames to, keeping their aspect ratio, or an invalid size for their actual size
+//! \param nearest Whether to scale by repeating pixels instead of smoothing them
+//!
+void PreviewCache::setScale(QSize size, bool nearest) {
+    if (size == this->size && nearest == this->nearest)
+        return;
+
+    this->size = size;
+    this->nearest = nearest;
+    clear();
+}
+
+//!
+//! \brief PreviewCache::frame Gets a frame scaled for the preview, scaling it first if the cached one is stale
+//! \param frames The frames
+//! \param index The frame to get
+//! \return The pixmap, valid until the next call
+//!
+const QPixmap &PreviewCache::frame(const FrameStore &frames, int index) {
+    if ((int)entries.size() != frames.frameCount())
+        entries.resize(frames.frameCount());
+
+    Entry &entry = entries[index];
+    quint64 version = frames.version(index);
+    if (entry.version == version)
+        return entry.pixmap;
+
+    // A frame sharing this one's pixels may have been scaled already
+    auto same = std::find_if(entries.begin(), entries.end(), [version](const Entry &other) { return other.version == version; });
+    if (same != entries.end()) {
+        entry = *same;
+        return entry.pixmap;
+    }
+
+    // Waiting for a frame already being scaled ahead is never slower than scaling it again
+    QImage image;
+    if (pending.index == index && pending.version == version) {
+        image = pending.image.result();
+        pending = Pending();
+    } else {
+        image = scaled(frames.image(index), size, nearest);
+    }
+    entry.pixmap = QPixmap::fromImage(image);
+    entry.version = version;
+    return entry.pixmap;
+}
+
+//!
+//! \brief PreviewCache::prepare Starts scaling a frame on a worker thread if it was drawn on since it was last
+//!        scaled, so it is ready when it is shown. Only one frame is scaled ahead at a time.
+//! \param frames The frames, a snapshot of them is taken if the frame needs scaling
+//! \param index The frame that will be shown next
+//!
+void PreviewCache::prepare(const FrameStore &frames, int index) {
+    // Frames shown at their actual size are only copied, which is not worth a thread
+    if (!size.isValid() || index < 0 || index >= frames.frameCount() || pending.image.isRunning())
+        return;
+
+    quint64 version = frames.version(index);
+    if ((pending.index == index && pending.version == version) || isCached(version))
+        return;
+
+    // The snapshot is dropped on this thread as soon as the frame is scaled, so the frames it shares are not held on
+    // to until the image is taken
+    pending = Pending();
+    pending.index = index;
+    pending.version = version;
+    pending.snapshot = frames.snapshot();
+    const FrameStore *snapshot = pending.snapshot.get();
+    QSize size = this->size;
+    bool nearest = this->nearest;
+    pending.image = QtConcurrent::run([snapshot, index, size, nearest] {
+        // The image must not point into the snapshot's pixels once it is dropped
+        QImage image = scaled(snapshot->image(index), size, nearest);
+        if (image.size() == QSize(snapshot->size(), snapshot->size()))
+            image = image.copy();
+        return image;
+    });
+    pendingWatcher.setFuture(pending.image);
+}
+
+//!
+//! \brief PreviewCache::releaseSnapshot Drops the snapshot a frame was scaled from once the worker is done with it.
+//!        This runs on the thread that owns the frames, so they are never written in place while the worker could
+//!        still be reading them.
+//!
+void PreviewCache::releaseSnapshot() {
+    if (pending.image.isFinished())
+        pending.snapshot.reset();
+}
+
+//!
+//! \brief PreviewCache::isCached Checks whether a version of a frame has already been scaled, for this frame or for
+//!        another frame sharing its pixels
+//! \param version The frame's version
+//! \return Whether a scaled pixmap of that version is cached
+//!
+bool PreviewCache::isCached(quint64 version) const {
+    return std::any_of(entries.begin(), entries.end(), [version](const Entry &entry) { return entry.version == version; });
+}
+
+//!
+//! \brief PreviewCache::scaled Scales a frame for the preview
+//! \param image The frame
+//! \param size The size to scale it to, keeping its aspect ratio, or an invalid size to leave it as it is
+//! \param nearest Whether to scale by repeating pixels instead of smoothing them
+//! \return The scaled frame
+//!
+QImage PreviewCache::scaled(const QImage &image, QSize size, bool nearest) {
+    if (!size.isValid())
+        return image;
+    return image.scaled(size, Qt::KeepAspectRatio, nearest ? Qt::FastTransformation : Qt::SmoothTransformation);
+}
+
+//!
+//! \brief PreviewCache::clear Throws away every cached frame
+//!
+void PreviewCache::clear() {
+    entries.clear();
+
+    // A frame still being scaled was scaled the old way, so its image is thrown away too
+    pending.image.waitForFinished();
+    pending = Pending();
+}
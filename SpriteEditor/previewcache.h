@@ -0,0 +1,70 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include "framestore.h"
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief PreviewCache Holds every frame already scaled for the preview, so playing it back only hands out pixmaps
+//!        that exist. A frame is only scaled again when it has been drawn on since (its FrameStore version changed)
+//!        or the preview's size or scaling changes, and frames with the same version share one pixmap.
+//!
+//!        A frame that was drawn on can be scaled ahead of time on a worker thread. The worker reads a snapshot of the
+//!        frames, so the canvas keeps being edited without any locking. The snapshot is dropped back on the thread
+//!        that owns the frames as soon as the frame is scaled. Its image is only used if the frame is still the
+//!        version that was snapshotted when it comes due.
+//!
+class PreviewCache
+{
+public:
+    PreviewCache();
+    ~PreviewCache();
+
+    void setScale(QSize size, bool nearest);
+    const QPixmap &frame(const FrameStore &frames, int index);
+    void prepare(const FrameStore &frames, int index);
+    void clear();
+
+private:
+    //!
+    //! \brief Entry One frame's scaled pixmap and the version of the frame it was made from, 0 if there is none
+    //!
+    struct Entry {
+        quint64 version = 0;
+        QPixmap pixmap;
+    };
+
+    //!
+    //! \brief Pending A frame being scaled on a worker thread
+    //!
+    struct Pending {
+        int index = -1;
+        quint64 version = 0;
+        QFuture<QImage> image;
+        FrameSnapshot snapshot;
+    };
+
+    vector<Entry> entries;
+    Pending pending;
+    QFutureWatcher<QImage> pendingWatcher;
+    QSize size;
+    bool nearest;
+
+    bool isCached(quint64 version) const;
+    void releaseSnapshot();
+    static QImage scaled(const QImage &image, QSize size, bool nearest);
+};
+
+#endif // PREVIEWCACHE_H
@@ -0,0 +1,196 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "previewclock.h"
+#include <cmath>
+
+// How often the achieved frame rate and jitter are reported, in nanoseconds
+static const qint64 reportInterval = 1000000000;
+
+//!
+//! \brief PreviewClock::PreviewClock Constructor, the clock starts stopped
+//! \param parent The parent object
+//!
+PreviewClock::PreviewClock(QObject *parent) : QObject{parent}, shownAt(statsWindow), lateness(statsWindow) {
+    fps = 1;
+    period = 1e9;
+    origin = 0;
+    originFrame = 0;
+    nextFrame = 0;
+    pausedAt = 0;
+    running = false;
+    paused = false;
+    dropped = 0;
+    statsCount = 0;
+    lastReport = 0;
+
+    // Frames are only a few milliseconds apart at high frame rates, so coarse timers are not good enough
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::PreciseTimer);
+    connect(&timer, &QTimer::timeout, this, &PreviewClock::onTimeout);
+}
+
+//!
+//! \brief PreviewClock::start Starts playback from frame 0, replacing any playback already running
+//! \param fps The number of frames per second
+//!
+void PreviewClock::start(double fps) {
+    stop();
+    this->fps = qMax(fps, 0.001);
+    period = 1e9 / this->fps;
+    clock.start();
+    origin = 0;
+    originFrame = 0;
+    nextFrame = 0;
+    dropped = 0;
+    statsCount = 0;
+    lastReport = 0;
+    running = true;
+    schedule();
+}
+
+//!
+//! \brief PreviewClock::stop Stops playback, nothing more is shown until it is started again
+//!
+void PreviewClock::stop() {
+    timer.stop();
+    running = false;
+    paused = false;
+}
+
+//!
+//! \brief PreviewClock::setPaused Pauses or resumes playback. Resuming carries on from the frame after the last one
+//!        shown, as if no time had passed while paused.
+//! \param paused Whether to pause
+//!
+void PreviewClock::setPaused(bool paused) {
+    if (!running || paused == this->paused)
+        return;
+
+    this->paused = paused;
+    if (paused) {
+        timer.stop();
+        pausedAt = clock.nsecsElapsed();
+    } else {
+        origin += clock.nsecsElapsed() - pausedAt;
+        schedule();
+    }
+}
+
+//!
+//! \brief PreviewClock::setFps Changes the frame rate. During playback the change takes effect from the next frame,
+//!        without restarting.
+//! \param fps The number of frames per second
+//!
+void PreviewClock::setFps(double fps) {
+    fps = qMax(fps, 0.001);
+    if (running) {
+        // The next frame stays due when it was, or sooner if the new rate is faster, and the new rate counts from it
+        qint64 now = paused ? pausedAt : clock.nsecsElapsed();
+        qint64 next = qMin(dueTime(nextFrame), now + qint64(1e9 / fps));
+        origin = next;
+        originFrame = nextFrame;
+    }
+    this->fps = fps;
+    period = 1e9 / fps;
+    if (running && !paused)
+        schedule();
+}
+
+//!
+//! \brief PreviewClock::achievedFps Works out the frame rate actually shown over the last second or so
+//! \return Frames per second, 0 before two frames have been shown
+//!
+double PreviewClock::achievedFps() const {
+    int count = qMin(statsCount, statsWindow);
+    if (count < 2)
+        return 0;
+
+    qint64 newest = shownAt[(statsCount - 1) % statsWindow];
+    qint64 oldest = shownAt[(statsCount - count) % statsWindow];
+    return newest > oldest ? (count - 1) * 1e9 / (newest - oldest) : 0;
+}
+
+//!
+//! \brief PreviewClock::jitter Works out how much the time frames are shown varies from when they were due
+//! \return The standard deviation of the lateness of recent frames, in milliseconds
+//!
+double PreviewClock::jitter() const {
+    int count = qMin(statsCount, statsWindow);
+    if (count < 2)
+        return 0;
+
+    double mean = 0;
+    for (int i = 0; i < count; i++)
+        mean += lateness[i];
+    mean /= count;
+
+    double variance = 0;
+    for (int i = 0; i < count; i++)
+        variance += (lateness[i] - mean) * (lateness[i] - mean);
+    return std::sqrt(variance / count) / 1e6;
+}
+
+//!
+//! \brief PreviewClock::dueTime Gets when a frame should be shown. Each frame is measured from the origin rather than
+//!        from the frame before it, so rounding never adds up into drift.
+//! \param frame The frame number since playback started
+//! \return The time on the clock, in nanoseconds
+//!
+qint64 PreviewClock::dueTime(qint64 frame) const {
+    return origin + qint64(std::llround((frame - originFrame) * period));
+}
+
+//!
+//! \brief PreviewClock::schedule Arms the timer for the next due frame, rounding up so it never fires early
+//!
+void PreviewClock::schedule() {
+    qint64 wait = dueTime(nextFrame) - clock.nsecsElapsed();
+    timer.start(int(qMax<qint64>(0, (wait + 999999) / 1000000)));
+}
+
+//!
+//! \brief PreviewClock::onTimeout Shows the newest frame that is due, dropping any older ones that were missed
+//!
+void PreviewClock::onTimeout() {
+    if (!running || paused)
+        return;
+
+    qint64 now = clock.nsecsElapsed();
+    if (now < dueTime(nextFrame)) {
+        schedule();
+        return;
+    }
+
+    qint64 frame = qMax(nextFrame, originFrame + qint64((now - origin) / period));
+    if (dueTime(frame) > now)
+        frame--;
+    dropped += frame - nextFrame;
+    nextFrame = frame + 1;
+    record(now, now - dueTime(frame));
+
+    emit frameDue(frame);
+
+    // A slot may have stopped or restarted playback
+    if (running && !paused && nextFrame == frame + 1)
+        schedule();
+}
+
+//!
+//! \brief PreviewClock::record Keeps the timing of a shown frame for the statistics, and reports them about once a
+//!        second
+//! \param now When the frame was shown
+//! \param late How long after it was due it was shown
+//!
+void PreviewClock::record(qint64 now, qint64 late) {
+    shownAt[statsCount % statsWindow] = now;
+    lateness[statsCount % statsWindow] = late;
+    statsCount++;
+
+    if (now - lastReport >= reportInterval) {
+        lastReport = now;
+        emit statsChanged(achievedFps(), jitter(), dropped);
+    }
+}
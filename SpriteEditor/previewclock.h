@@ -0,0 +1,68 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef PREVIEWCLOCK_H
+#define PREVIEWCLOCK_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief PreviewClock Decides when each preview frame is shown. Frame n is due at a fixed time on a monotonic clock,
+//!        worked out from when playback started rather than from the previous frame, so late frames never push the
+//!        following ones back. One timer is re-armed for the next due frame, and if the event loop falls behind the
+//!        frames that were missed are dropped instead of being shown late.
+//!
+class PreviewClock : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PreviewClock(QObject *parent = nullptr);
+
+    void start(double fps);
+    void stop();
+    void setPaused(bool paused);
+    void setFps(double fps);
+
+    bool isRunning() const { return running; }
+    bool isPaused() const { return paused; }
+    double achievedFps() const;
+    double jitter() const;
+    qint64 droppedFrames() const { return dropped; }
+
+signals:
+    void frameDue(qint64 frame);
+    void statsChanged(double achievedFps, double jitterMs, qint64 droppedFrames);
+
+private:
+    static constexpr int statsWindow = 60;
+
+    QElapsedTimer clock;
+    QTimer timer;
+    double fps;
+    double period;
+    qint64 origin;
+    qint64 originFrame;
+    qint64 nextFrame;
+    qint64 pausedAt;
+    bool running;
+    bool paused;
+    qint64 dropped;
+    vector<qint64> shownAt;
+    vector<qint64> lateness;
+    int statsCount;
+    qint64 lastReport;
+
+    qint64 dueTime(qint64 frame) const;
+    void schedule();
+    void onTimeout();
+    void record(qint64 now, qint64 late);
+};
+
+#endif // PREVIEWCLOCK_H
@@ -0,0 +1,162 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "projectfile.h"
+#include "sspbfile.h"
+#include "sspreader.h"
+#include "sspwriter.h"
+#include <QtConcurrent>
+#include <algorithm>
+
+//!
+//! \brief ProjectFile::load Opens a JSON (.ssp) or binary (.sspb) sprite. The file is read into a separate store, so a
+//!        bad file leaves the frames as they were.
+//! \param filename The file to be opened (includes path)
+//! \param frames The store to replace with the sprite's frames
+//! \param pool Decodes .ssp frames in parallel on this pool, or on the calling thread if null
+//! \param error Set to the reason the file could not be read
+//! \param progress Counts the frames read, and stops the load if cancelled
+//! \return Whether the sprite was read
+//!
+bool ProjectFile::load(const QString &filename, FrameStore &frames, QThreadPool *pool, QString *error, FileProgress *progress) {
+    FrameStore loaded;
+
+    if (SspbFile::isSspb(filename)) {
+        // Mapped frames cost no memory until they are drawn on, and comparing them would read in the whole file
+        if (!SspbFile::read(filename, loaded, error, progress))
+            return false;
+    } else {
+        SspReader reader;
+        reader.setProgress(progress);
+        if (!reader.open(filename) || !reader.read(loaded, pool)) {
+            if (error) *error = reader.errorString();
+            return false;
+        }
+
+        // Repeated frames, such as held poses, only need to be decoded into memory once
+        loaded.deduplicate();
+    }
+    frames.swap(loaded);
+    return true;
+}
+
+//!
+//! \brief ProjectFile::loadLazily Opens a sprite without decoding its frames. Only the first frame is decoded, to
+//!        check the file, and every other frame is decoded the first time it is shown, previewed or saved. Binary
+//!        (.sspb) files are already read straight from the mapped file, so they open as with load.
+//! \param filename The file to be opened (includes path)
+//! \param frames The store to replace with the sprite's frames
+//! \param error Set to the reason the file could not be read
+//! \param progress Counts the frames found, and stops the load if cancelled
+//! \return Whether the sprite was opened
+//!
+bool ProjectFile::loadLazily(const QString &filename, FrameStore &frames, QString *error, FileProgress *progress) {
+    if (SspbFile::isSspb(filename))
+        return load(filename, frames, nullptr, error, progress);
+
+    // The reader keeps the file mapped until every frame from it has been decoded
+    auto reader = std::make_shared<SspReader>();
+    reader->setProgress(progress);
+    bool opened = reader->open(filename) && reader->readHeader();
+    reader->setProgress(nullptr);
+    if (!opened) {
+        if (error) *error = reader->errorString();
+        return false;
+    }
+
+    FrameStore loaded(reader->size());
+    loaded.addFrame();
+    if (!reader->decodeFrame(0, loaded.bits(0))) {
+        if (error) *error = "frame0 is not a " + QString::number(reader->size()) + " by " + QString::number(reader->size()) + " array of pixels";
+        return false;
+    }
+    for (int i = 1; i < reader->frameCount(); i++)
+        loaded.addLazyFrame(reader, i);
+
+    frames.swap(loaded);
+    return true;
+}
+
+//!
+//! \brief ProjectFile::decodeAll Decodes every frame that has not been decoded yet
+//! \param frames The frames to decode
+//! \param pool Decodes frames in parallel on this pool, or on the calling thread if null
+//! \param progress Counts the frames decoded, and skips the rest if cancelled
+//! \param error Set to the first frame that could not be decoded
+//! \return Whether every frame has its real pixels, false if one could not be decoded or it was cancelled
+//!
+bool ProjectFile::decodeAll(const FrameStore &frames, QThreadPool *pool, FileProgress *progress, QString *error) {
+    vector<int> undecoded;
+    for (int i = 0; i < frames.frameCount(); i++) {
+        if (!frames.isDecoded(i)) undecoded.push_back(i);
+    }
+    if (progress)
+        progress->start((int)undecoded.size());
+
+    auto decode = [&frames, progress](const int &frame) {
+        if (progress && progress->isCancelled())
+            return;
+        frames.constBits(frame);
+        if (progress) progress->advance();
+    };
+    if (pool && undecoded.size() > 1)
+        QtConcurrent::blockingMap(pool, undecoded, decode);
+    else
+        std::for_each(undecoded.begin(), undecoded.end(), decode);
+    if (progress && progress->isCancelled())
+        return false;
+
+    // A frame that failed, now or when it was first shown, only holds a transparent placeholder
+    for (int i = 0; i < frames.frameCount(); i++) {
+        if (frames.isCorrupt(i)) {
+            if (error) *error = "frame" + QString::number(i) + " could not be read from the file it was opened from";
+            return false;
+        }
+    }
+    return true;
+}
+
+//!
+//! \brief ProjectFile::save Saves the sprite as JSON (.ssp), or as raw scanlines when the file name ends in .sspb.
+//!        Nothing is written if a frame could not be decoded, since its placeholder would replace the real pixels,
+//!        usually in the very file they came from.
+//! \param frames The frames to save
+//! \param filename The file to write (includes path)
+//! \param compact Whether to leave out the indentation in a .ssp
+//! \param pool Encodes .ssp frames in parallel on this pool, or on the calling thread if null
+//! \param progress Counts the frames decoded and then the frames written, and stops the save if cancelled. A
+//!        cancelled save leaves the old file as it was.
+//! \param error Set to the reason the sprite was not saved
+//! \return Whether the whole sprite was written
+//!
+bool ProjectFile::save(const FrameStore &frames, const QString &filename, bool compact, QThreadPool *pool, FileProgress *progress, QString *error) {
+    // Frames still waiting to be decoded may be reading from the very file about to be overwritten, which has to be
+    // closed before it can be replaced
+    if (!decodeAll(frames, pool, progress, error))
+        return false;
+    frames.forgetSources(filename);
+    if (progress)
+        progress->start(frames.frameCount());
+
+    bool written;
+    if (SspbFile::isSspb(filename)) {
+        written = SspbFile::write(frames, filename, progress);
+    } else {
+        SspWriter writer(frames, compact);
+        written = writer.write(filename, pool, progress);
+    }
+    if (!written && error && !(progress && progress->isCancelled()))
+        *error = "Unable to write " + filename;
+    return written;
+}
+
+//!
+//! \brief ProjectFile::isProject Checks whether a file name is for a sprite project in either format
+//! \param filename The file name
+//! \return Whether it ends in .ssp or .sspb
+//!
+bool ProjectFile::isProject(const QString &filename) {
+    return filename.endsWith(".ssp", Qt::CaseInsensitive) || SspbFile::isSspb(filename);
+}
@@ -0,0 +1,29 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef PROJECTFILE_H
+#define PROJECTFILE_H
+
+#include "fileprogress.h"
+#include "framestore.h"
+#include <QString>
+#include <QThreadPool>
+
+//!
+//! \brief ProjectFile Opens and saves sprite projects in either format, picking .sspb or .ssp by the file name. It only
+//!        needs QtCore and QtGui, so the editor and the command line tool share it. Every call can be given a
+//!        FileProgress, which lets a load or save running on another thread report each frame and be cancelled.
+//!
+class ProjectFile
+{
+public:
+    static bool load(const QString &filename, FrameStore &frames, QThreadPool *pool = nullptr, QString *error = nullptr, FileProgress *progress = nullptr);
+    static bool loadLazily(const QString &filename, FrameStore &frames, QString *error = nullptr, FileProgress *progress = nullptr);
+    static bool save(const FrameStore &frames, const QString &filename, bool compact = false, QThreadPool *pool = nullptr, FileProgress *progress = nullptr, QString *error = nullptr);
+    static bool isProject(const QString &filename);
+    static bool decodeAll(const FrameStore &frames, QThreadPool *pool = nullptr, FileProgress *progress = nullptr, QString *error = nullptr);
+};
+
+#endif // PROJECTFILE_H
@@ -0,0 +1,349 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "framestore.h"
+#include "projectfile.h"
+#include <QCollator>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// The largest frame the editor opens
+static const int maxFrameSize = 4096;
+
+//!
+//! \brief Options The command and settings shared by every file processed
+//!
+struct Options {
+    QString command;
+    QString format;
+    int columns = 0;
+    int size = 0;
+    bool compact = false;
+};
+
+//!
+//! \brief Job One file to process, and how it went
+//!
+struct Job {
+    QString input;
+    QString output;
+    bool ok = false;
+    QString message;
+};
+
+//!
+//! \brief exportFrames Saves every frame as its own PNG, named <name>_<frame>.png
+//! \param frames The frames to save
+//! \param directory The directory to save them in, created if needed
+//! \param name The start of each file name
+//! \param error Set to the reason a frame could not be saved
+//! \return Whether every frame was saved
+//!
+static bool exportFrames(const FrameStore &frames, const QString &directory, const QString &name, QString *error) {
+    QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        *error = "Unable to create " + directory;
+        return false;
+    }
+
+    for (int i = 0; i < frames.frameCount(); i++) {
+        QString path = dir.filePath(name + "_" + QString::number(i) + ".png");
+        if (!frames.image(i).save(path, "PNG")) {
+            *error = "Unable to write " + path;
+            return false;
+        }
+    }
+    return true;
+}
+
+//!
+//! \brief sheetImage Lays every frame out left to right, top to bottom in one image. The frame count is stored in the
+//!        PNG so importing the sheet does not pick up the empty cells after the last frame.
+//! \param frames The frames to lay out
+//! \param columns Frames per row, or 0 for a roughly square sheet
+//! \return The sheet
+//!
+static QImage sheetImage(const FrameStore &frames, int columns) {
+    int count = frames.frameCount();
+    int size = frames.size();
+    if (columns <= 0) columns = (int)std::ceil(std::sqrt((double)count));
+    columns = qMin(columns, count);
+    int rows = (count + columns - 1) / columns;
+
+    QImage sheet(columns * size, rows * size, QImage::Format_RGBA8888);
+    sheet.fill(Qt::transparent);
+    for (int i = 0; i < count; i++) {
+        int left = i % columns * size;
+        int top = i / columns * size;
+        for (int y = 0; y < size; y++)
+            std::memcpy(reinterpret_cast<Pixel *>(sheet.scanLine(top + y)) + left, frames.constScanLine(i, y), frames.bytesPerLine());
+    }
+    sheet.setText("Frames", QString::number(count));
+    return sheet;
+}
+
+//!
+//! \brief addImageFrame Appends a frame copied from part of an image
+//! \param image The image, in QImage::Format_RGBA8888
+//! \param left The left edge of the frame in the image
+//! \param top The top edge of the frame in the image
+//! \param frames The store to add the frame to
+//!
+static void addImageFrame(const QImage &image, int left, int top, FrameStore &frames) {
+    int frame = frames.addFrame();
+    for (int y = 0; y < frames.size(); y++)
+        std::memcpy(frames.scanLine(frame, y), reinterpret_cast<const Pixel *>(image.constScanLine(top + y)) + left, frames.bytesPerLine());
+}
+
+//!
+//! \brief importSheet Splits a PNG sprite sheet into frames
+//! \param filename The sheet
+//! \param size The width and height of each frame, or 0 to use the sheet's height
+//! \param frames The store to fill, anything already in it is removed
+//! \param error Set to the reason the sheet could not be split
+//! \return Whether the sheet was read
+//!
+static bool importSheet(const QString &filename, int size, FrameStore &frames, QString *error) {
+    QImage sheet(filename);
+    if (sheet.isNull()) {
+        *error = "Unable to read " + filename;
+        return false;
+    }
+    sheet = sheet.convertToFormat(QImage::Format_RGBA8888);
+
+    if (size <= 0) size = sheet.height();
+    if (size < 1 || size > maxFrameSize || sheet.width() % size != 0 || sheet.height() % size != 0) {
+        *error = QString("A %1x%2 sheet cannot be split into %3x%3 frames").arg(sheet.width()).arg(sheet.height()).arg(size);
+        return false;
+    }
+
+    int columns = sheet.width() / size;
+    int count = columns * (sheet.height() / size);
+    bool stored;
+    int storedCount = sheet.text("Frames").toInt(&stored);
+    if (stored && storedCount >= 1 && storedCount <= count) count = storedCount;
+
+    frames.reset(size);
+    for (int i = 0; i < count; i++)
+        addImageFrame(sheet, i % columns * size, i / columns * size, frames);
+    return true;
+}
+
+//!
+//! \brief importFrames Builds frames from a directory of PNGs, in natural order so frame_10 comes after frame_9
+//! \param directory The directory of PNGs
+//! \param frames The store to fill, anything already in it is removed
+//! \param error Set to the reason the frames could not be read
+//! \return Whether every frame was read
+//!
+static bool importFrames(const QString &directory, FrameStore &frames, QString *error) {
+    QStringList files = QDir(directory).entryList(QStringList() << "*.png", QDir::Files);
+    if (files.isEmpty()) {
+        *error = "No PNG frames in " + directory;
+        return false;
+    }
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(files.begin(), files.end(), collator);
+
+    for (int i = 0; i < files.size(); i++) {
+        QString path = QDir(directory).filePath(files[i]);
+        QImage image(path);
+        if (image.isNull()) {
+            *error = "Unable to read " + path;
+            return false;
+        }
+        if (i == 0) {
+            if (image.width() != image.height() || image.height() < 1 || image.height() > maxFrameSize) {
+                *error = path + " is not a square frame the editor supports";
+                return false;
+            }
+            frames.reset(image.height());
+        }
+        if (image.width() != frames.size() || image.height() != frames.size()) {
+            *error = path + " is not the same size as the first frame";
+            return false;
+        }
+        addImageFrame(image.convertToFormat(QImage::Format_RGBA8888), 0, 0, frames);
+    }
+    return true;
+}
+
+//!
+//! \brief runJob Runs the command on one file
+//! \param job The file, filled in with how it went
+//! \param options The command and its settings
+//! \param pool Spreads the frames of this one file over threads, or null when files are already processed in parallel
+//!
+static void runJob(Job &job, const Options &options, QThreadPool *pool) {
+    QString error;
+    FrameStore frames;
+
+    if (options.command == "import") {
+        bool read = QFileInfo(job.input).isDir() ? importFrames(job.input, frames, &error) : importSheet(job.input, options.size, frames, &error);
+        if (!read) {
+            job.message = error;
+            return;
+        }
+        if (!ProjectFile::save(frames, job.output, options.compact, pool)) {
+            job.message = "Unable to write " + job.output;
+            return;
+        }
+        job.ok = true;
+        job.message = QString("%1 frames of %2x%2 written to %3").arg(frames.frameCount()).arg(frames.size()).arg(job.output);
+        return;
+    }
+
+    if (!ProjectFile::load(job.input, frames, pool, &error)) {
+        job.message = error.isEmpty() ? "Unable to read the project" : error;
+        return;
+    }
+
+    if (options.command == "convert") {
+        if (!ProjectFile::save(frames, job.output, options.compact, pool)) {
+            job.message = "Unable to write " + job.output;
+            return;
+        }
+    } else if (options.command == "frames") {
+        if (!exportFrames(frames, job.output, QFileInfo(job.input).completeBaseName(), &error)) {
+            job.message = error;
+            return;
+        }
+    } else if (options.command == "sheet") {
+        if (!sheetImage(frames, options.columns).save(job.output, "PNG")) {
+            job.message = "Unable to write " + job.output;
+            return;
+        }
+    }
+
+    job.ok = true;
+    job.message = QString("%1 frames of %2x%2").arg(frames.frameCount()).arg(frames.size());
+    if (!job.output.isEmpty()) job.message += ", written to " + job.output;
+}
+
+//!
+//! \brief batchOutput Works out where one project of a directory goes
+//! \param input The project
+//! \param outputDirectory The directory given on the command line
+//! \param options The command and its settings
+//! \return The output path
+//!
+static QString batchOutput(const QString &input, const QString &outputDirectory, const Options &options) {
+    QFileInfo info(input);
+    QDir dir(outputDirectory);
+    if (options.command == "convert") {
+        // Without a format every project is converted to the other one
+        QString format = options.format.isEmpty() ? (info.suffix().compare("sspb", Qt::CaseInsensitive) == 0 ? "ssp" : "sspb") : options.format;
+        return dir.filePath(info.completeBaseName() + "." + format);
+    }
+    if (options.command == "sheet")
+        return dir.filePath(info.completeBaseName() + ".png");
+    return outputDirectory;
+}
+
+//!
+//! \brief main Converts, exports, imports and validates sprite projects without opening a window. Only QtCore is
+//!        started, so it needs no display and no platform plugin.
+//!
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("spritec");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Batch tool for A7 Sprite Editor projects (.ssp and .sspb).\n\n"
+        "Commands:\n"
+        "  validate <project|dir>            Checks that every project opens\n"
+        "  convert  <project|dir> <output>   Saves as .ssp or .sspb, picked by the output name or --format\n"
+        "  frames   <project|dir> <dir>      Exports each frame as <dir>/<name>_<frame>.png\n"
+        "  sheet    <project|dir> <output>   Exports the frames as one PNG sprite sheet\n"
+        "  import   <sheet.png|dir> <output> Builds a project from a sprite sheet or a directory of PNG frames\n\n"
+        "Given a directory, every project in it is processed in parallel and the output is a directory.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command", "validate, convert, frames, sheet or import");
+    parser.addPositionalArgument("input", "A project, PNG sheet or directory");
+    parser.addPositionalArgument("output", "Where to write the result", "[output]");
+
+    QCommandLineOption jobsOption("jobs", "Threads to use (default: one per core).", "count");
+    QCommandLineOption formatOption("format", "Project format when converting a directory: ssp or sspb.", "format");
+    QCommandLineOption columnsOption("columns", "Frames per row of a sprite sheet (default: a roughly square sheet).", "count");
+    QCommandLineOption sizeOption("size", "Frame size when importing a sheet (default: the sheet's height).", "pixels");
+    QCommandLineOption compactOption("compact", "Write .ssp files without indentation.");
+    parser.addOptions({ jobsOption, formatOption, columnsOption, sizeOption, compactOption });
+    parser.process(app);
+
+    QStringList arguments = parser.positionalArguments();
+    Options options;
+    options.command = arguments.value(0);
+    options.format = parser.value(formatOption).toLower();
+    options.columns = parser.value(columnsOption).toInt();
+    options.size = parser.value(sizeOption).toInt();
+    options.compact = parser.isSet(compactOption);
+
+    static const QStringList commands = { "validate", "convert", "frames", "sheet", "import" };
+    bool needsOutput = options.command != "validate";
+    if (!commands.contains(options.command) || arguments.size() != (needsOutput ? 3 : 2)
+        || (!options.format.isEmpty() && options.format != "ssp" && options.format != "sspb")) {
+        parser.showHelp(2);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(parser.isSet(jobsOption) ? qMax(1, parser.value(jobsOption).toInt()) : QThread::idealThreadCount());
+
+    QString input = arguments[1];
+    QString output = arguments.value(2);
+    vector<Job> jobs;
+
+    if (QFileInfo(input).isDir() && options.command != "import") {
+        // Every project in the directory is processed on its own thread, decoding its frames serially
+        QDir dir(input);
+        for (const QString &file : dir.entryList(QStringList() << "*.ssp" << "*.sspb", QDir::Files, QDir::Name)) {
+            Job job;
+            job.input = dir.filePath(file);
+            if (needsOutput) job.output = batchOutput(job.input, output, options);
+            jobs.push_back(job);
+        }
+        if (jobs.empty()) {
+            std::cerr << "No .ssp or .sspb projects in " << qPrintable(input) << std::endl;
+            return 1;
+        }
+        if (needsOutput && !QDir().mkpath(output)) {
+            std::cerr << "Unable to create " << qPrintable(output) << std::endl;
+            return 1;
+        }
+        QtConcurrent::blockingMap(&pool, jobs, [&options](Job &job) { runJob(job, options, nullptr); });
+    } else {
+        Job job;
+        job.input = input;
+        job.output = output;
+        jobs.push_back(job);
+        runJob(jobs.back(), options, pool.maxThreadCount() > 1 ? &pool : nullptr);
+    }
+
+    // Results are printed in order once everything is done, so the output is the same however it was scheduled
+    int failed = 0;
+    for (const Job &job : jobs) {
+        if (job.ok) {
+            std::cout << qPrintable(job.input) << ": " << qPrintable(job.message) << std::endl;
+        } else {
+            std::cerr << qPrintable(job.input) << ": error: " << qPrintable(job.message) << std::endl;
+            failed++;
+        }
+    }
+    if (jobs.size() > 1)
+        std::cout << jobs.size() - failed << " of " << jobs.size() << " files succeeded" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+QT       += core gui concurrent
+QT       -= widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = spritec
+
+# Builds the editor's file format sources without any of its widgets, so it runs with no display or platform plugin
+INCLUDEPATH += ..
+
+SOURCES += \
+    main.cpp \
+    ../framepool.cpp \
+    ../framestore.cpp \
+    ../projectfile.cpp \
+    ../sspbfile.cpp \
+    ../sspreader.cpp \
+    ../sspwriter.cpp
+
+HEADERS += \
+    ../fileprogress.h \
+    ../framepool.h \
+    ../framestore.h \
+    ../projectfile.h \
+    ../sspbfile.h \
+    ../sspreader.h \
+    ../sspwriter.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,178 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "sspbfile.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+static const char magic[4] = { 'S', 'S', 'P', 'B' };
+static const quint32 formatVersion = 1;
+static const quint32 pixelFormatRgba8 = 1;
+static const qint64 headerBytes = 64;
+static const qint64 frameAlignment = 64;
+static const int maxFrameSize = 4096;
+
+//!
+//! \brief alignUp Rounds a file offset up to the next frame boundary
+//!
+static qint64 alignUp(qint64 offset) {
+    return (offset + frameAlignment - 1) & ~(frameAlignment - 1);
+}
+
+//!
+//! \brief writePadding Writes zero bytes until the file reaches an offset
+//! \return Whether the padding was written
+//!
+static bool writePadding(QSaveFile &file, qint64 &position, qint64 offset) {
+    static const char zeros[frameAlignment] = {};
+    qint64 count = offset - position;
+    position = offset;
+    return count == 0 || file.write(zeros, count) == count;
+}
+
+//!
+//! \brief SspbFile::isSspb Checks whether a file name is for the binary format
+//! \param filename The file name
+//! \return Whether it ends in .sspb
+//!
+bool SspbFile::isSspb(const QString &filename) {
+    return filename.endsWith(".sspb", Qt::CaseInsensitive);
+}
+
+//!
+//! \brief SspbFile::write Saves the sprite in the binary format. The file is written to a temporary file and then
+//!        renamed over the old one, so a failed save leaves the old file as it was. Windows will not rename over a file
+//!        that is still mapped, so frames mapped from it must be unmapped first (FrameStore::unmapFile).
+//! \param frames The frames to save
+//! \param filename The file to write (includes path)
+//! \param progress Counts the frames written, and stops the save if cancelled
+//! \return Whether the whole sprite was written
+//!
+bool SspbFile::write(const FrameStore &frames, const QString &filename, FileProgress *progress) {
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    int frameCount = frames.frameCount();
+    qint64 frameStride = alignUp(frames.frameBytes());
+    qint64 firstFrame = alignUp(headerBytes + 8 * qint64(frameCount));
+
+    // Fixed size header
+    uchar header[headerBytes] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    qToLittleEndian<quint32>(formatVersion, header + 4);
+    qToLittleEndian<quint32>(frames.size(), header + 8);
+    qToLittleEndian<quint32>(frames.size(), header + 12);
+    qToLittleEndian<quint32>(frameCount, header + 16);
+    qToLittleEndian<quint32>(pixelFormatRgba8, header + 20);
+    qToLittleEndian<quint32>(frames.bytesPerLine(), header + 24);
+
+    // Frame offset table
+    QByteArray table(8 * qsizetype(frameCount), '\0');
+    for (int i = 0; i < frameCount; i++)
+        qToLittleEndian<quint64>(firstFrame + i * frameStride, table.data() + 8 * qsizetype(i));
+
+    qint64 position = headerBytes + table.size();
+    if (file.write(reinterpret_cast<const char *>(header), headerBytes) != headerBytes || file.write(table) != table.size())
+        return false;
+
+    // Raw scanlines, each frame starting on an aligned offset
+    for (int i = 0; i < frameCount; i++) {
+        if (progress && progress->isCancelled())
+            return false;
+        if (!writePadding(file, position, firstFrame + i * frameStride))
+            return false;
+        if (file.write(reinterpret_cast<const char *>(frames.constBits(i)), frames.frameBytes()) != frames.frameBytes())
+            return false;
+        position += frames.frameBytes();
+        if (progress) progress->advance();
+    }
+
+    return file.commit();
+}
+
+//!
+//! \brief SspbFile::read Opens a binary sprite. The file is mapped copy-on-write and every frame points into the
+//!        mapping, which stays alive until the last of those frames is removed. If the file cannot be mapped the
+//!        frames are read into memory instead.
+//! \param filename The file to be opened (includes path)
+//! \param frames The store to fill, anything already in it is removed
+//! \param error Set to the reason the file could not be read
+//! \param progress Counts the frames read, and stops the read if cancelled
+//! \return Whether the sprite was read
+//!
+bool SspbFile::read(const QString &filename, FrameStore &frames, QString *error, FileProgress *progress) {
+    auto fail = [error](const QString &message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    std::shared_ptr<QFile> file = std::make_shared<QFile>(filename);
+    if (!file->open(QIODevice::ReadOnly))
+        return fail("Unable to open " + filename);
+
+    qint64 fileSize = file->size();
+    if (fileSize < headerBytes)
+        return fail("The file is too small to be a binary sprite");
+
+    uchar *mapped = file->map(0, fileSize, QFileDevice::MapPrivateOption);
+    QByteArray contents;
+    const uchar *view = mapped;
+    if (!mapped) {
+        contents = file->readAll();
+        view = reinterpret_cast<const uchar *>(contents.constData());
+        fileSize = contents.size();
+    }
+
+    // Check the header
+    if (fileSize < headerBytes || std::memcmp(view, magic, sizeof(magic)) != 0)
+        return fail("The file is not a binary sprite");
+    if (qFromLittleEndian<quint32>(view + 4) != formatVersion || qFromLittleEndian<quint32>(view + 20) != pixelFormatRgba8)
+        return fail("Unsupported binary sprite version or pixel format");
+
+    quint32 width = qFromLittleEndian<quint32>(view + 8);
+    quint32 height = qFromLittleEndian<quint32>(view + 12);
+    quint32 frameCount = qFromLittleEndian<quint32>(view + 16);
+    quint32 bytesPerLine = qFromLittleEndian<quint32>(view + 24);
+    if (width != height)
+        return fail("Only square sprites are supported");
+    if (height < 1 || height > (quint32)maxFrameSize || bytesPerLine != height * sizeof(Pixel) || frameCount < 1)
+        return fail("Unsupported sprite size or frame count");
+    if (headerBytes + 8 * qint64(frameCount) > fileSize)
+        return fail("The frame table is truncated");
+
+    // Check every frame is inside the file before handing any of them out. Frames start on an aligned offset after
+    // the table, each after the end of the one before, so no two frames can point at the same pixels.
+    qint64 frameBytes = qint64(height) * bytesPerLine;
+    qint64 nextFree = headerBytes + 8 * qint64(frameCount);
+    vector<qint64> offsets(frameCount);
+    for (quint32 i = 0; i < frameCount; i++) {
+        quint64 offset = qFromLittleEndian<quint64>(view + headerBytes + 8 * qint64(i));
+        if (offset > quint64(fileSize) || qint64(offset) > fileSize - frameBytes)
+            return fail("frame" + QString::number(i) + " is outside the file");
+        if (offset % frameAlignment != 0 || qint64(offset) < nextFree)
+            return fail("frame" + QString::number(i) + " is not aligned or overlaps the frame before it");
+        offsets[i] = qint64(offset);
+        nextFree = offsets[i] + frameBytes;
+    }
+
+    frames.reset(height);
+    if (progress)
+        progress->start(frameCount);
+    for (quint32 i = 0; i < frameCount; i++) {
+        if (progress && progress->isCancelled())
+            return fail("Cancelled");
+        if (mapped) {
+            frames.addExternalFrame(reinterpret_cast<Pixel *>(mapped + offsets[i]), file, filename);
+        } else {
+            int frame = frames.addFrame();
+            std::memcpy(frames.bits(frame), view + offsets[i], frameBytes);
+        }
+        if (progress) progress->advance();
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef SSPBFILE_H
+#define SSPBFILE_H
+
+#include "fileprogress.h"
+#include "framestore.h"
+#include <QString>
+
+//!
+//! \brief SspbFile Reads and writes the binary sprite sheet project format (.sspb). The file is a fixed 64 byte
+//!        header, a table with the byte offset of every frame, and then each frame's raw RGBA8 scanlines starting
+//!        on a 64 byte boundary. All integers are little endian.
+//!
+//!        header: "SSPB", version, width, height, frame count, pixel format, bytes per line, reserved up to 64 bytes
+//!
+//!        The pixels are the same 8 bit [r, g, b, a] values a .ssp holds, so converting between the two is lossless.
+//!        Opening maps the file copy-on-write and the frames point straight into the mapping, so nothing is copied
+//!        until a frame is painted on.
+//!
+class SspbFile
+{
+public:
+    static bool write(const FrameStore &frames, const QString &filename, FileProgress *progress = nullptr);
+    static bool read(const QString &filename, FrameStore &frames, QString *error = nullptr, FileProgress *progress = nullptr);
+    static bool isSspb(const QString &filename);
+};
+
+#endif // SSPBFILE_H
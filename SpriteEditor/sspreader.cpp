@@ -0,0 +1,531 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "sspreader.h"
+#include <QFileInfo>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+// Frames named beyond this are ignored rather than growing the frame table without bound
+static const int maxFrameIndex = 1 << 20;
+static const int maxFrameSize = 4096;
+
+//!
+//! \brief skipSpace Moves past any JSON whitespace
+//!
+static inline void skipSpace(const char *data, qsizetype length, qsizetype &pos) {
+    while (pos < length && (data[pos] == ' ' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '\t'))
+        pos++;
+}
+
+//!
+//! \brief expect Moves past whitespace and then the given character
+//! \return Whether the character was there
+//!
+static inline bool expect(const char *data, qsizetype length, qsizetype &pos, char c) {
+    skipSpace(data, length, pos);
+    if (pos < length && data[pos] == c) {
+        pos++;
+        return true;
+    }
+    return false;
+}
+
+//!
+//! \brief skipString Moves past a string, pos must be on its opening quote
+//! \return Whether the string was closed
+//!
+static bool skipString(const char *data, qsizetype length, qsizetype &pos) {
+    for (pos++; pos < length; pos++) {
+        if (data[pos] == '\\') pos++;
+        else if (data[pos] == '"') {
+            pos++;
+            return true;
+        }
+    }
+    return false;
+}
+
+//!
+//! \brief readKey Reads an object key and the colon after it
+//! \param key Set to the start of the key's raw text
+//! \param keyLength Set to the length of the key's raw text
+//! \return Whether a key was read
+//!
+static bool readKey(const char *data, qsizetype length, qsizetype &pos, const char *&key, qsizetype &keyLength) {
+    skipSpace(data, length, pos);
+    if (pos >= length || data[pos] != '"')
+        return false;
+
+    qsizetype start = pos + 1;
+    if (!skipString(data, length, pos))
+        return false;
+
+    key = data + start;
+    keyLength = pos - 1 - start;
+    return expect(data, length, pos, ':');
+}
+
+//!
+//! \brief keyIs Compares a raw key with a name
+//!
+static inline bool keyIs(const char *key, qsizetype keyLength, const char *name) {
+    return keyLength == (qsizetype)std::strlen(name) && std::memcmp(key, name, keyLength) == 0;
+}
+
+//!
+//! \brief skipValue Moves past any JSON value without looking inside it, only brackets and strings are tracked
+//! \return Whether a complete value was skipped
+//!
+static bool skipValue(const char *data, qsizetype length, qsizetype &pos) {
+    skipSpace(data, length, pos);
+    if (pos >= length)
+        return false;
+
+    char c = data[pos];
+    if (c == '"')
+        return skipString(data, length, pos);
+
+    if (c == '[' || c == '{') {
+        int depth = 0;
+        while (pos < length) {
+            c = data[pos];
+            if (c == '"') {
+                if (!skipString(data, length, pos)) return false;
+                continue;
+            }
+            if (c == '[' || c == '{') depth++;
+            else if (c == ']' || c == '}') depth--;
+            pos++;
+            if (depth == 0) return true;
+        }
+        return false;
+    }
+
+    // Numbers, true, false and null all end at a separator
+    qsizetype start = pos;
+    while (pos < length && !std::strchr(",]} \t\r\n", data[pos]))
+        pos++;
+    return pos > start;
+}
+
+//!
+//! \brief readInteger Reads a number that must be a whole value, such as 32 or 32.0
+//! \return Whether an integer was read
+//!
+static bool readInteger(const char *data, qsizetype length, qsizetype &pos, int &value) {
+    skipSpace(data, length, pos);
+    qsizetype start = pos;
+    while (pos < length && std::strchr("+-0123456789.eE", data[pos]) && data[pos] != '\0')
+        pos++;
+    if (pos == start)
+        return false;
+
+    // Converting a number outside the range of int is undefined, so it is checked first
+    bool ok;
+    double number = QByteArray(data + start, pos - start).toDouble(&ok);
+    if (!ok || !(number >= INT_MIN && number <= INT_MAX) || number != std::trunc(number))
+        return false;
+    value = (int)number;
+    return true;
+}
+
+//!
+//! \brief readChannel Reads one 0-255 channel value, plain digits are decoded without leaving the buffer
+//! \return Whether a channel value was read
+//!
+static inline bool readChannel(const char *data, qsizetype length, qsizetype &pos, int &value) {
+    skipSpace(data, length, pos);
+    qsizetype start = pos;
+    int number = 0;
+    while (pos < length && pos - start < 4 && data[pos] >= '0' && data[pos] <= '9')
+        number = number * 10 + (data[pos++] - '0');
+
+    // Anything other than up to three plain digits goes through the general number path
+    if (pos == start || pos - start > 3 || (pos < length && (data[pos] == '.' || data[pos] == 'e' || data[pos] == 'E'))) {
+        pos = start;
+        if (!readInteger(data, length, pos, number))
+            return false;
+    }
+
+    value = number;
+    return number >= 0 && number <= 255;
+}
+
+//!
+//! \brief SspReader::SspReader Constructor
+//!
+SspReader::SspReader() : data(nullptr), length(0), frameSize(0), numberOfFrames(0), progress(nullptr) {
+}
+
+//!
+//! \brief SspReader::~SspReader Destructor, closing the file also unmaps it
+//!
+SspReader::~SspReader() {
+}
+
+//!
+//! \brief SspReader::fail Records why the file could not be read
+//! \param message The reason
+//! \return Always false
+//!
+bool SspReader::fail(const QString &message) {
+    error = message;
+    return false;
+}
+
+//!
+//! \brief SspReader::open Opens and maps a file, falling back to reading it into memory if it cannot be mapped
+//! \param filename The file to be opened (includes path)
+//! \return Whether the file was opened
+//!
+bool SspReader::open(const QString &filename) {
+    file.setFileName(filename);
+    if (!file.open(QIODevice::ReadOnly))
+        return fail("Unable to open " + filename);
+
+    stamp = currentStamp(filename);
+    length = file.size();
+    data = reinterpret_cast<const char *>(file.map(0, length));
+    if (!data) {
+        fallback = file.readAll();
+        data = fallback.constData();
+        length = fallback.size();
+    }
+    return true;
+}
+
+//!
+//! \brief SspReader::currentStamp Gets the size and modification time a file has now, in the same form as fileStamp
+//! \param filename The file (includes path)
+//! \return The stamp, or an empty one if there is no such file
+//!
+QByteArray SspReader::currentStamp(const QString &filename) {
+    QFileInfo info(filename);
+    if (!info.exists())
+        return QByteArray();
+
+    QByteArray stamp(16, '\0');
+    qToLittleEndian<qint64>(info.size(), stamp.data());
+    qToLittleEndian<qint64>(info.lastModified().toMSecsSinceEpoch(), stamp.data() + 8);
+    return stamp;
+}
+
+//!
+//! \brief SspReader::readHeader Reads the size fields and finds every frame without decoding any pixels
+//! \return Whether the file is a sprite this editor can open
+//!
+bool SspReader::readHeader() {
+    qsizetype pos = 0;
+    int height = -1;
+    int width = -1;
+    bool hasFrames = false;
+    numberOfFrames = -1;
+    frameRanges.clear();
+    vector<FrameRange> index;
+    bool indexed = readFrameIndex(index);
+
+    // Skip a UTF-8 byte order mark if there is one
+    if (length >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        pos = 3;
+
+    if (!expect(data, length, pos, '{'))
+        return fail("The file is not a JSON object");
+
+    if (!expect(data, length, pos, '}')) {
+        while (true) {
+            const char *key;
+            qsizetype keyLength;
+            if (!readKey(data, length, pos, key, keyLength))
+                return fail("Expected a field name");
+
+            bool ok;
+            if (keyIs(key, keyLength, "height")) ok = readInteger(data, length, pos, height);
+            else if (keyIs(key, keyLength, "width")) ok = readInteger(data, length, pos, width);
+            else if (keyIs(key, keyLength, "numberOfFrames")) ok = readInteger(data, length, pos, numberOfFrames);
+            else if (keyIs(key, keyLength, "frames")) ok = hasFrames = (indexed && skipIndexedFrames(pos, index)) || readFramesObject(pos);
+            else ok = skipValue(data, length, pos);
+
+            if (!ok && progress && progress->isCancelled())
+                return fail("Cancelled");
+            if (!ok)
+                return fail("Invalid value for " + QString::fromUtf8(key, keyLength));
+            if (expect(data, length, pos, '}'))
+                break;
+            if (!expect(data, length, pos, ','))
+                return fail("Expected ',' or '}'");
+        }
+    }
+
+    // Check for any errors
+    if (height < 0 || width < 0 || numberOfFrames < 0 || !hasFrames)
+        return fail("Missing height, width, numberOfFrames or frames");
+    if (height != width)
+        return fail("Only square sprites are supported");
+    if (height < 1 || height > maxFrameSize || numberOfFrames < 1)
+        return fail("Unsupported sprite size or frame count");
+
+    // Every pixel takes at least 9 bytes ("[0,0,0,0]"), so a count the file cannot hold is rejected before any memory
+    // is set aside for it
+    if (numberOfFrames > maxFrameIndex || qint64(numberOfFrames) * height * height * 9 > length)
+        return fail("numberOfFrames is larger than the file can hold");
+
+    // Every frame counted must be in the file, so none is silently opened blank
+    for (int i = 0; i < numberOfFrames; i++) {
+        if (i >= (int)frameRanges.size() || frameRanges[i].begin < 0)
+            return fail("frame" + QString::number(i) + " is missing");
+    }
+
+    frameSize = height;
+    frameRanges.resize(numberOfFrames);
+    return true;
+}
+
+//!
+//! \brief SspReader::readFramesObject Records where each "frameN" array is in the frames object
+//! \param pos The position of the object, moved past it
+//! \return Whether the object was well formed
+//!
+bool SspReader::readFramesObject(qsizetype &pos) {
+    if (!expect(data, length, pos, '{'))
+        return false;
+    if (progress)
+        progress->start(qMax(numberOfFrames, 0));
+    if (expect(data, length, pos, '}'))
+        return true;
+
+    while (true) {
+        const char *key;
+        qsizetype keyLength;
+        if (!readKey(data, length, pos, key, keyLength))
+            return false;
+
+        // Work out the frame number from the key
+        int index = -1;
+        if (keyLength > 5 && std::memcmp(key, "frame", 5) == 0) {
+            bool ok;
+            index = QByteArray(key + 5, keyLength - 5).toInt(&ok);
+            if (!ok || index < 0 || index >= maxFrameIndex) index = -1;
+        }
+
+        skipSpace(data, length, pos);
+        qsizetype begin = pos;
+        if (!skipValue(data, length, pos))
+            return false;
+
+        if (index >= 0 && data[begin] == '[') {
+            if (index >= (int)frameRanges.size()) frameRanges.resize(index + 1);
+            frameRanges[index].begin = begin;
+            frameRanges[index].end = pos;
+            if (progress) {
+                progress->advance();
+                if (progress->isCancelled()) return false;
+            }
+        }
+
+        if (expect(data, length, pos, '}'))
+            return true;
+        if (!expect(data, length, pos, ','))
+            return false;
+    }
+}
+
+//!
+//! \brief SspReader::readFrameIndex Reads the "frameIndex" field, which holds the begin and end of every frame's array
+//!        in the file. It is always the last field, so only the end of the file is looked at.
+//! \param index Set to where each frame is according to the index
+//! \return Whether the file has an index
+//!
+bool SspReader::readFrameIndex(vector<FrameRange> &index) const {
+    auto skipSpaceBack = [this](qsizetype &pos) {
+        while (pos > 0 && std::strchr(" \t\r\n", data[pos - 1]) && data[pos - 1] != '\0') pos--;
+    };
+
+    // The file ends with the index array and then the document's closing brace
+    qsizetype pos = length;
+    skipSpaceBack(pos);
+    if (pos == 0 || data[--pos] != '}')
+        return false;
+    skipSpaceBack(pos);
+    if (pos == 0 || data[pos - 1] != ']')
+        return false;
+    qsizetype close = pos - 1;
+
+    // The index is a flat array of numbers, so the nearest '[' opens it
+    qsizetype open = close;
+    while (open > 0 && data[open] != '[')
+        open--;
+    pos = open;
+    skipSpaceBack(pos);
+    if (pos == 0 || data[--pos] != ':')
+        return false;
+    skipSpaceBack(pos);
+    static const char key[] = "\"frameIndex\"";
+    qsizetype keyLength = sizeof(key) - 1;
+    if (pos < keyLength || std::memcmp(data + pos - keyLength, key, keyLength) != 0)
+        return false;
+
+    // Read the pairs of offsets
+    pos = open + 1;
+    vector<qint64> offsets;
+    if (!expect(data, close + 1, pos, ']')) {
+        while (true) {
+            skipSpace(data, close, pos);
+            qsizetype start = pos;
+            while (pos < close && data[pos] >= '0' && data[pos] <= '9')
+                pos++;
+            bool ok;
+            qint64 offset = QByteArray(data + start, pos - start).toLongLong(&ok);
+            if (pos == start || !ok)
+                return false;
+            offsets.push_back(offset);
+
+            if (expect(data, close + 1, pos, ']'))
+                break;
+            if (!expect(data, close, pos, ','))
+                return false;
+        }
+    }
+    if (offsets.size() % 2 != 0 || offsets.size() / 2 > size_t(maxFrameIndex))
+        return false;
+
+    index.resize(offsets.size() / 2);
+    for (size_t i = 0; i < index.size(); i++) {
+        index[i].begin = offsets[2 * i];
+        index[i].end = offsets[2 * i + 1];
+    }
+    return true;
+}
+
+//!
+//! \brief SspReader::skipIndexedFrames Uses the index to record where each frame is and jump to the end of the
+//!        frames object. Every entry is checked against the file, so a stale or damaged index is never trusted.
+//! \param pos The position of the frames object, moved past it
+//! \param index Where each frame is according to the index
+//! \return Whether the index matched the file, pos is unchanged if not
+//!
+bool SspReader::skipIndexedFrames(qsizetype &pos, const vector<FrameRange> &index) {
+    qsizetype next = pos;
+    if (!expect(data, length, next, '{'))
+        return false;
+
+    for (int i = 0; i < (int)index.size(); i++) {
+        const FrameRange &range = index[i];
+        if (range.begin < next || range.end <= range.begin || range.end > length
+            || data[range.begin] != '[' || data[range.end - 1] != ']')
+            return false;
+
+        // The frame's key and a colon must come right before its array
+        QByteArray key = "\"frame" + QByteArray::number(i) + "\"";
+        qsizetype keyEnd = range.begin;
+        while (keyEnd > next && std::strchr(" \t\r\n", data[keyEnd - 1]) && data[keyEnd - 1] != '\0') keyEnd--;
+        if (keyEnd <= next || data[--keyEnd] != ':')
+            return false;
+        while (keyEnd > next && std::strchr(" \t\r\n", data[keyEnd - 1]) && data[keyEnd - 1] != '\0') keyEnd--;
+        if (keyEnd - next < key.size() || std::memcmp(data + keyEnd - key.size(), key.constData(), key.size()) != 0)
+            return false;
+
+        next = range.end;
+    }
+
+    if (!expect(data, length, next, '}'))
+        return false;
+    frameRanges = index;
+    pos = next;
+    if (progress) {
+        progress->start((int)index.size());
+        progress->advance((int)index.size());
+    }
+    return true;
+}
+
+//!
+//! \brief SspReader::decodeFrame Decodes one frame's pixels into a buffer. Safe to call for different frames at the
+//!        same time.
+//! \param frame The frame number
+//! \param bits The size * size pixel buffer to decode into
+//! \return Whether the frame was a size by size array of [r, g, b, a] pixels
+//!
+bool SspReader::decodeFrame(int frame, Pixel *bits) const {
+    const FrameRange &range = frameRanges[frame];
+
+    // Never look outside this frame's array
+    qsizetype pos = range.begin;
+    qsizetype end = range.end;
+
+    if (!expect(data, end, pos, '['))
+        return false;
+
+    // Loop through the rows
+    for (int y = 0; y < frameSize; y++) {
+        if ((y > 0 && !expect(data, end, pos, ',')) || !expect(data, end, pos, '['))
+            return false;
+        Pixel *line = bits + qsizetype(y) * frameSize;
+
+        // Loop through the pixels in the row
+        for (int x = 0; x < frameSize; x++) {
+            int r, g, b, a;
+            if ((x > 0 && !expect(data, end, pos, ',')) || !expect(data, end, pos, '[')
+                || !readChannel(data, end, pos, r) || !expect(data, end, pos, ',')
+                || !readChannel(data, end, pos, g) || !expect(data, end, pos, ',')
+                || !readChannel(data, end, pos, b) || !expect(data, end, pos, ',')
+                || !readChannel(data, end, pos, a) || !expect(data, end, pos, ']'))
+                return false;
+            line[x] = packPixel(r, g, b, a);
+        }
+
+        if (!expect(data, end, pos, ']'))
+            return false;
+    }
+
+    return expect(data, end, pos, ']');
+}
+
+//!
+//! \brief SspReader::read Reads the whole sprite into a frame store
+//! \param frames The store to fill, anything already in it is removed
+//! \param pool The threads to decode frames on, or nullptr to decode them on this thread
+//! \return Whether the sprite was read
+//!
+bool SspReader::read(FrameStore &frames, QThreadPool *pool) {
+    if (!readHeader())
+        return false;
+
+    // Allocate every frame up front so the decoders only ever touch their own frame
+    frames.reset(frameSize);
+    for (int i = 0; i < numberOfFrames; i++)
+        frames.addFrame();
+
+    // A cancelled read skips the frames not started yet, which then fail below
+    vector<char> decoded(numberOfFrames);
+    if (progress)
+        progress->start(numberOfFrames);
+    auto decode = [&](const int &frame) {
+        if (progress && progress->isCancelled())
+            return;
+        decoded[frame] = decodeFrame(frame, frames.bits(frame));
+        if (progress) progress->advance();
+    };
+
+    if (pool && numberOfFrames > 1) {
+        vector<int> order(numberOfFrames);
+        std::iota(order.begin(), order.end(), 0);
+        QtConcurrent::blockingMap(pool, order, decode);
+    } else {
+        for (int i = 0; i < numberOfFrames; i++) decode(i);
+    }
+
+    if (progress && progress->isCancelled())
+        return fail("Cancelled");
+    for (int i = 0; i < numberOfFrames; i++) {
+        if (!decoded[i])
+            return fail("frame" + QString::number(i) + " is not a " + QString::number(frameSize) + " by " + QString::number(frameSize) + " array of pixels");
+    }
+    return true;
+}
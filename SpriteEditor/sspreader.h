@@ -0,0 +1,73 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef SSPREADER_H
+#define SSPREADER_H
+
+#include "fileprogress.h"
+#include "framestore.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QThreadPool>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief SspReader Reads a .ssp sprite sheet project without building a JSON document. The file is memory mapped,
+//!        a quick structural pass finds the header fields and where each "frameN" array starts and ends, and each
+//!        frame's [r, g, b, a] tuples are then decoded straight into a frame buffer, optionally many frames at once.
+//!        Files this editor writes end with a "frameIndex" of where each frame is, which lets the structural pass
+//!        jump over the frames instead of reading through them. As a FrameSource it can also decode frames lazily.
+//!        Given a FileProgress, both passes count the frames they get through and stop early if it is cancelled.
+//!
+class SspReader : public FrameSource
+{
+public:
+    SspReader();
+    ~SspReader();
+
+    bool open(const QString &filename);
+    bool readHeader();
+    bool decodeFrame(int frame, Pixel *bits) const override;
+    QString fileName() const override { return file.fileName(); }
+    QByteArray fileStamp() const override { return stamp; }
+    bool read(FrameStore &frames, QThreadPool *pool = nullptr);
+    void setProgress(FileProgress *progress) { this->progress = progress; }
+
+    int size() const { return frameSize; }
+    int frameCount() const { return numberOfFrames; }
+    QString errorString() const { return error; }
+
+    static QByteArray currentStamp(const QString &filename);
+
+private:
+    //!
+    //! \brief FrameRange Where one frame's array sits in the file, begin is the opening '[' and end is one past the ']'
+    //!
+    struct FrameRange {
+        qsizetype begin = -1;
+        qsizetype end = -1;
+    };
+
+    QFile file;
+    QByteArray stamp;
+    QByteArray fallback;
+    const char *data;
+    qsizetype length;
+    int frameSize;
+    int numberOfFrames;
+    vector<FrameRange> frameRanges;
+    QString error;
+    FileProgress *progress;
+
+    bool fail(const QString &message);
+    bool readFramesObject(qsizetype &pos);
+    bool readFrameIndex(vector<FrameRange> &index) const;
+    bool skipIndexedFrames(qsizetype &pos, const vector<FrameRange> &index);
+};
+
+#endif // SSPREADER_H
@@ -0,0 +1,220 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "sspwriter.h"
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <cstring>
+#include <numeric>
+
+// Indented output uses the same four space indentation as QJsonDocument::toJson, but it is only equivalent JSON, not
+// byte for byte the same, since the keys are written in the editor's order rather than sorted
+static const char indent[] = "                    ";
+static const int frameIndent = 8;
+static const int rowIndent = 12;
+static const int pixelIndent = 16;
+static const int channelIndent = 20;
+
+//!
+//! \brief ChannelText The decimal text of every channel value, so encoding a pixel never formats a number
+//!
+struct ChannelText {
+    char text[256][4];
+    int length[256];
+
+    ChannelText() {
+        for (int value = 0; value < 256; value++) {
+            QByteArray digits = QByteArray::number(value);
+            std::memcpy(text[value], digits.constData(), digits.size());
+            length[value] = digits.size();
+        }
+    }
+};
+
+static const ChannelText &channelText() {
+    static const ChannelText table;
+    return table;
+}
+
+//!
+//! \brief SspWriter::SspWriter Constructor
+//! \param frames The frames to write
+//! \param compact Whether to leave out all indentation and newlines
+//!
+SspWriter::SspWriter(const FrameStore &frames, bool compact) : frames(frames), compact(compact) {
+}
+
+//!
+//! \brief SspWriter::write Writes the sprite to a file. It is written to a temporary file that only replaces the old
+//!        one once every frame is written, so a failed or cancelled save leaves the old file as it was.
+//! \param filename The file to write (includes path)
+//! \param pool The threads to encode frames on, or nullptr to encode them on this thread
+//! \param progress Counts the frames written, and stops the save if cancelled
+//! \return Whether the whole sprite was written
+//!
+bool SspWriter::write(const QString &filename, QThreadPool *pool, FileProgress *progress) const {
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return write(&file, pool, progress) && file.commit();
+}
+
+//!
+//! \brief SspWriter::write Writes the sprite to an open device. Frames are encoded in batches of one per thread and
+//!        each batch is written in frame order, so memory stays at one encoded frame per thread.
+//! \param device The device to write to
+//! \param pool The threads to encode frames on, or nullptr to encode them on this thread
+//! \param progress Counts the frames written, and stops the save between batches if cancelled
+//! \return Whether the whole sprite was written
+//!
+bool SspWriter::write(QIODevice *device, QThreadPool *pool, FileProgress *progress) const {
+    int frameCount = frames.frameCount();
+    int batchSize = pool ? qMax(1, pool->maxThreadCount()) : 1;
+
+    // The buffers are reused for every batch
+    QByteArray buffer;
+    vector<QByteArray> encoded(qMin(batchSize, qMax(frameCount, 1)));
+    vector<qint64> index(2 * qsizetype(frameCount));
+    qint64 written = 0;
+    appendHeader(buffer);
+
+    for (int first = 0; first < frameCount; first += batchSize) {
+        if (progress && progress->isCancelled())
+            return false;
+        int last = qMin(frameCount, first + batchSize);
+        auto encode = [&](const int &frame) {
+            QByteArray &out = encoded[frame - first];
+            out.resize(0);
+            encodeFrame(frame, out);
+        };
+
+        if (pool && last - first > 1) {
+            vector<int> batch(last - first);
+            std::iota(batch.begin(), batch.end(), first);
+            QtConcurrent::blockingMap(pool, batch, encode);
+        } else {
+            for (int i = first; i < last; i++) encode(i);
+        }
+
+        // Write the batch in frame order
+        for (int i = first; i < last; i++) {
+            appendFrameKey(i, buffer);
+            index[2 * i] = written + buffer.size();
+            buffer += encoded[i - first];
+            index[2 * i + 1] = written + buffer.size();
+            if (device->write(buffer) != buffer.size())
+                return false;
+            written += buffer.size();
+            buffer.resize(0);
+            if (progress) progress->advance();
+        }
+    }
+
+    appendFooter(index, buffer);
+    return device->write(buffer) == buffer.size();
+}
+
+//!
+//! \brief SspWriter::appendHeader Appends the size fields and opens the frames object
+//! \param out The buffer to append to
+//!
+void SspWriter::appendHeader(QByteArray &out) const {
+    QByteArray size = QByteArray::number(frames.size());
+    QByteArray count = QByteArray::number(frames.frameCount());
+
+    if (compact) {
+        out += "{\"height\":" + size + ",\"width\":" + size + ",\"numberOfFrames\":" + count + ",\"frames\":{";
+    } else {
+        out += "{\n    \"height\": " + size + ",\n    \"width\": " + size + ",\n    \"numberOfFrames\": " + count + ",\n    \"frames\": {\n";
+    }
+}
+
+//!
+//! \brief SspWriter::appendFrameKey Appends the "frameN" key, preceded by a separator for every frame after the first
+//! \param frame The frame number
+//! \param out The buffer to append to
+//!
+void SspWriter::appendFrameKey(int frame, QByteArray &out) const {
+    if (compact) {
+        if (frame > 0) out += ',';
+        out += "\"frame" + QByteArray::number(frame) + "\":";
+    } else {
+        if (frame > 0) out += ",\n";
+        out.append(indent, frameIndent);
+        out += "\"frame" + QByteArray::number(frame) + "\": ";
+    }
+}
+
+//!
+//! \brief SspWriter::appendFooter Closes the frames object, adds the frame index and closes the document
+//! \param index The begin and end offset of each frame's array
+//! \param out The buffer to append to
+//!
+void SspWriter::appendFooter(const vector<qint64> &index, QByteArray &out) const {
+    QByteArray offsets;
+    for (size_t i = 0; i < index.size(); i++) {
+        if (i > 0) offsets += compact ? "," : ", ";
+        offsets += QByteArray::number(index[i]);
+    }
+
+    if (compact) {
+        out += "},\"frameIndex\":[" + offsets + "]}";
+    } else {
+        if (frames.frameCount() > 0) out += '\n';
+        out += "    },\n    \"frameIndex\": [" + offsets + "]\n}\n";
+    }
+}
+
+//!
+//! \brief SspWriter::encodeFrame Appends one frame as an array of rows of [r, g, b, a] pixels
+//! \param frame The frame to encode
+//! \param out The buffer to append to
+//!
+void SspWriter::encodeFrame(int frame, QByteArray &out) const {
+    const ChannelText &table = channelText();
+    int size = frames.size();
+
+    // Reserve for the widest case so appending never reallocates mid-frame
+    qsizetype pixelBytes = compact ? 18 : 4 * (channelIndent + 5) + 2 * (pixelIndent + 3);
+    out.reserve(out.size() + qsizetype(size) * size * pixelBytes + qsizetype(size) * 2 * (rowIndent + 3) + frameIndent + 4);
+
+    out += compact ? "[" : "[\n";
+    for (int y = 0; y < size; y++) {
+        const Pixel *line = frames.constScanLine(frame, y);
+
+        if (compact) {
+            out += '[';
+            for (int x = 0; x < size; x++) {
+                out += x > 0 ? ",[" : "[";
+                for (int channel = 0; channel < 4; channel++) {
+                    int value = pixelChannel(line[x], channel);
+                    if (channel > 0) out += ',';
+                    out.append(table.text[value], table.length[value]);
+                }
+                out += ']';
+            }
+            out += y < size - 1 ? "]," : "]";
+        } else {
+            out.append(indent, rowIndent);
+            out += "[\n";
+            for (int x = 0; x < size; x++) {
+                out.append(indent, pixelIndent);
+                out += "[\n";
+                for (int channel = 0; channel < 4; channel++) {
+                    int value = pixelChannel(line[x], channel);
+                    out.append(indent, channelIndent);
+                    out.append(table.text[value], table.length[value]);
+                    out += channel < 3 ? ",\n" : "\n";
+                }
+                out.append(indent, pixelIndent);
+                out += x < size - 1 ? "],\n" : "]\n";
+            }
+            out.append(indent, rowIndent);
+            out += y < size - 1 ? "],\n" : "]\n";
+        }
+    }
+    if (!compact) out.append(indent, frameIndent);
+    out += ']';
+}
@@ -0,0 +1,40 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef SSPWRITER_H
+#define SSPWRITER_H
+
+#include "fileprogress.h"
+#include "framestore.h"
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QThreadPool>
+
+//!
+//! \brief SspWriter Streams a frame store out as a .ssp sprite sheet project, encoding the JSON text straight from
+//!        the frame scanlines one frame at a time instead of building a QJsonDocument. Given a thread pool, frames
+//!        are encoded in parallel and still written in order, giving exactly the same bytes as the serial path.
+//!        The last field is a "frameIndex" of where each frame's array begins and ends in the file, which other
+//!        readers ignore and SspReader uses to find frames without reading through them.
+//!
+class SspWriter
+{
+public:
+    explicit SspWriter(const FrameStore &frames, bool compact = false);
+
+    bool write(const QString &filename, QThreadPool *pool = nullptr, FileProgress *progress = nullptr) const;
+    bool write(QIODevice *device, QThreadPool *pool = nullptr, FileProgress *progress = nullptr) const;
+    void encodeFrame(int frame, QByteArray &out) const;
+
+private:
+    const FrameStore &frames;
+    bool compact;
+    void appendHeader(QByteArray &out) const;
+    void appendFrameKey(int frame, QByteArray &out) const;
+    void appendFooter(const vector<qint64> &index, QByteArray &out) const;
+};
+
+#endif // SSPWRITER_H
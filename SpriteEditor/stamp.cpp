@@ -0,0 +1,48 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "stamp.h"
+#include <cmath>
+
+//!
+//! \brief Stamp::Stamp Rasterizes a shape centered on a pixel
+//! \param shape Whether the stamp is a rectangle or an ellipse
+//! \param radiusX How many pixels the shape reaches left and right of its center, 0 for one pixel wide
+//! \param radiusY How many pixels the shape reaches above and below its center, 0 for one pixel tall
+//!
+Stamp::Stamp(Shape shape, int radiusX, int radiusY) {
+    radiusX = qMax(0, radiusX);
+    radiusY = qMax(0, radiusY);
+
+    for (int y = -radiusY; y <= radiusY; y++) {
+        int reach = radiusX;
+        if (shape == Circle) {
+            // Pixel centers a little past the edge are covered too, so the outermost rows and columns are more than a
+            // single pixel, while a radius of 1 still comes out as a plus rather than a square
+            double rx = radiusX + 0.35;
+            double ry = radiusY + 0.35;
+            double across = 1.0 - (y * y) / (ry * ry);
+            reach = qMin(radiusX, int(std::floor(rx * std::sqrt(qMax(0.0, across)))));
+        }
+        rows.push_back(PixelKernels::Span { y, -reach, reach });
+    }
+}
+
+//!
+//! \brief Stamp::spansAt Places the stamp and clips it to the frame
+//! \param center The pixel the stamp is centered on
+//! \param size The width and height of the frame
+//! \param spans Where the runs inside the frame are added
+//!
+void Stamp::spansAt(QPoint center, int size, vector<PixelKernels::Span> &spans) const {
+    for (const PixelKernels::Span &row : rows) {
+        int y = center.y() + row.y;
+        int left = qMax(0, center.x() + row.left);
+        int right = qMin(size - 1, center.x() + row.right);
+        if (y < 0 || y >= size || left > right)
+            continue;
+        spans.push_back(PixelKernels::Span { y, left, right });
+    }
+}
@@ -0,0 +1,35 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef STAMP_H
+#define STAMP_H
+
+#include "pixelkernels.h"
+#include <QPoint>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief Stamp A brush or shape tool's footprint, rasterized once into the runs of pixels it covers on each row,
+//!        relative to its center. Stamping it only offsets and clips those runs, so a large shape costs one fill per
+//!        row instead of one call per pixel.
+//!
+class Stamp
+{
+public:
+    enum Shape { Rectangle, Circle };
+
+    Stamp() = default;
+    Stamp(Shape shape, int radiusX, int radiusY);
+
+    void spansAt(QPoint center, int size, vector<PixelKernels::Span> &spans) const;
+    bool isEmpty() const { return rows.empty(); }
+
+private:
+    vector<PixelKernels::Span> rows;
+};
+
+#endif // STAMP_H
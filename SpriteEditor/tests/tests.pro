@@ -0,0 +1,50 @@
+QT       += core gui widgets concurrent testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tests
+
+# The tests build the editor's own sources rather than linking the app
+INCLUDEPATH += ..
+
+SOURCES += \
+    tst_spriteeditor.cpp \
+    ../autosavejournal.cpp \
+    ../canvasitem.cpp \
+    ../frameeditor.cpp \
+    ../framepool.cpp \
+    ../framestore.cpp \
+    ../model.cpp \
+    ../pixelkernels.cpp \
+    ../previewcache.cpp \
+    ../previewclock.cpp \
+    ../projectfile.cpp \
+    ../sspbfile.cpp \
+    ../sspreader.cpp \
+    ../sspwriter.cpp \
+    ../stamp.cpp \
+    ../trace.cpp \
+    ../undohistory.cpp
+
+HEADERS += \
+    ../autosavejournal.h \
+    ../canvasitem.h \
+    ../frameeditor.h \
+    ../fileprogress.h \
+    ../framepool.h \
+    ../framestore.h \
+    ../model.h \
+    ../pixelkernels.h \
+    ../previewcache.h \
+    ../previewclock.h \
+    ../projectfile.h \
+    ../sspbfile.h \
+    ../sspreader.h \
+    ../sspwriter.h \
+    ../stamp.h \
+    ../trace.h \
+    ../undohistory.h
+
+FORMS += \
+    ../frameeditor.ui
@@ -0,0 +1,291 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include "autosavejournal.h"
+#include "frameeditor.h"
+#include "framestore.h"
+#include "model.h"
+#include "projectfile.h"
+#include "undohistory.h"
+#include <cctype>
+#include <cstring>
+
+//!
+//! \brief SpriteEditorTests Checks that damaged files are refused rather than half read or overwritten, and that
+//!        autosave and undo keep what they must. Unlike the benchmarks these time nothing, so they run in moments.
+//!
+class SpriteEditorTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void saveCorruptFrame();
+    void malformedSsp_data();
+    void malformedSsp();
+    void malformedSspb_data();
+    void malformedSspb();
+    void autosaveLazyFrames();
+    void saveOverMappedSspb();
+    void undoOverBudget();
+
+private:
+    QTemporaryDir projects;
+};
+
+//!
+//! \brief fillPattern Fills every frame with a different, busy pattern
+//! \param frames The frames to fill
+//!
+static void fillPattern(FrameStore &frames) {
+    for (int frame = 0; frame < frames.frameCount(); frame++) {
+        for (int y = 0; y < frames.size(); y++) {
+            for (int x = 0; x < frames.size(); x++)
+                frames.setPixel(frame, x, y, packPixel((x * 7 + frame) & 0xff, (y * 13) & 0xff, (x ^ y) & 0xff, 255));
+        }
+    }
+}
+
+//!
+//! \brief SpriteEditorTests::initTestCase Checks there is somewhere to write the test projects
+//!
+void SpriteEditorTests::initTestCase() {
+    QVERIFY(projects.isValid());
+}
+
+//!
+//! \brief SpriteEditorTests::saveCorruptFrame Opens a project with a frame that cannot be decoded and saves over it,
+//!        which must fail and leave the file as it was rather than writing the frame out blank
+//!
+void SpriteEditorTests::saveCorruptFrame() {
+    FrameStore frames(16);
+    frames.addFrame();
+    frames.addFrame();
+    fillPattern(frames);
+    QString path = projects.filePath("corrupt.ssp");
+    QVERIFY(ProjectFile::save(frames, path));
+
+    // Swap a digit of the second frame for a letter, keeping every array where the frame index says it is
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray contents = file.readAll();
+    file.close();
+    qsizetype digit = contents.indexOf("\"frame1\"");
+    QVERIFY(digit >= 0);
+    digit += qsizetype(std::strlen("\"frame1\""));
+    while (digit < contents.size() && !std::isdigit(uchar(contents[digit]))) digit++;
+    contents[digit] = 'x';
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    file.close();
+
+    Model model;
+    model.loadFile(path);
+    model.waitForFileJob();
+    QCOMPARE(model.frames.frameCount(), 2);
+
+    QSignalSpy failed(&model, &Model::saveImageError);
+    model.saveFile(path);
+    model.waitForFileJob();
+    QCOMPARE(failed.count(), 1);
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), contents);
+}
+
+void SpriteEditorTests::malformedSsp_data() {
+    QTest::addColumn<QByteArray>("contents");
+    QTest::addColumn<bool>("valid");
+
+    // A one pixel wide sprite declaring the size and frame count given, holding the number of frames given
+    auto sprite = [](const QByteArray &size, const QByteArray &frameCount, int frames) {
+        QByteArray contents = "{\"height\":" + size + ",\"width\":" + size + ",\"numberOfFrames\":" + frameCount + ",\"frames\":{";
+        for (int i = 0; i < frames; i++)
+            contents += (i > 0 ? ",\"frame" : "\"frame") + QByteArray::number(i) + "\":[[[1,2,3,4]]]";
+        return contents + "}}";
+    };
+    QTest::newRow("as written") << sprite("1", "2", 2) << true;
+    QTest::newRow("frame missing") << sprite("1", "2", 1) << false;
+    QTest::newRow("more frames than the file holds") << sprite("1", "2000000000", 1) << false;
+    QTest::newRow("size out of range") << sprite("1e300", "1", 1) << false;
+    QTest::newRow("count out of range") << sprite("1", "4294967297", 1) << false;
+}
+
+//!
+//! \brief SpriteEditorTests::malformedSsp Opens a JSON sprite whose header does not match its frames, which must be
+//!        refused rather than opened with blank or missing frames
+//!
+void SpriteEditorTests::malformedSsp() {
+    QFETCH(QByteArray, contents);
+    QFETCH(bool, valid);
+
+    QString path = projects.filePath("malformed.ssp");
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    file.close();
+
+    FrameStore loaded;
+    QString error;
+    QCOMPARE(ProjectFile::load(path, loaded, nullptr, &error), valid);
+    QCOMPARE(error.isEmpty(), valid);
+}
+
+void SpriteEditorTests::malformedSspb_data() {
+    QTest::addColumn<int>("frame");
+    QTest::addColumn<qint64>("shift");
+    QTest::addColumn<bool>("valid");
+    QTest::newRow("as written") << 1 << qint64(0) << true;
+    QTest::newRow("not aligned") << 1 << qint64(4) << false;
+    QTest::newRow("overlaps the frame before") << 1 << qint64(-64) << false;
+    QTest::newRow("same as the frame before") << 2 << qint64(-16 * 16 * 4) << false;
+    QTest::newRow("before the frame before") << 2 << qint64(-2 * 16 * 16 * 4) << false;
+    QTest::newRow("inside the table") << 0 << qint64(-64) << false;
+    QTest::newRow("past the end") << 2 << qint64(16 * 16 * 4) << false;
+}
+
+//!
+//! \brief SpriteEditorTests::malformedSspb Moves one entry of a binary sprite's frame table, which must only open when
+//!        every frame is aligned, after the table, and after the end of the frame before it
+//!
+void SpriteEditorTests::malformedSspb() {
+    QFETCH(int, frame);
+    QFETCH(qint64, shift);
+    QFETCH(bool, valid);
+
+    FrameStore frames(16);
+    for (int i = 0; i < 3; i++)
+        frames.addFrame();
+    fillPattern(frames);
+    QString path = projects.filePath("malformed.sspb");
+    QVERIFY(ProjectFile::save(frames, path));
+
+    // The table of 8 byte offsets follows the 64 byte header
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QByteArray contents = file.readAll();
+    char *entry = contents.data() + 64 + 8 * frame;
+    qToLittleEndian<quint64>(qFromLittleEndian<quint64>(entry) + shift, entry);
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.write(contents), qint64(contents.size()));
+    file.close();
+
+    FrameStore loaded;
+    QString error;
+    QCOMPARE(ProjectFile::load(path, loaded, nullptr, &error), valid);
+    QCOMPARE(error.isEmpty(), valid);
+}
+
+//!
+//! \brief SpriteEditorTests::autosaveLazyFrames Checkpoints a project that was just opened, which must not decode the
+//!        frames nobody has looked at, then checks the journal still recovers every frame
+//!
+void SpriteEditorTests::autosaveLazyFrames() {
+    FrameStore written(256);
+    for (int i = 0; i < 8; i++)
+        written.addFrame();
+    fillPattern(written);
+    QString path = projects.filePath("lazy.ssp");
+    QVERIFY(ProjectFile::save(written, path));
+
+    FrameStore frames;
+    QVERIFY(ProjectFile::loadLazily(path, frames));
+    frames.setPixel(1, 0, 0, packPixel(255, 0, 0, 255));
+
+    AutosaveJournal journal(projects.filePath("lazy.sspj"));
+    QVERIFY(journal.checkpoint(*frames.snapshot()));
+    for (int i = 2; i < frames.frameCount(); i++)
+        QVERIFY(!frames.isDecoded(i));
+
+    // Only the two decoded frames are in the journal as pixels
+    QVERIFY(QFileInfo(journal.fileName()).size() < 3 * frames.frameBytes());
+
+    FrameStore recovered;
+    QVERIFY(AutosaveJournal::recover(journal.fileName(), recovered));
+    QCOMPARE(recovered.frameCount(), frames.frameCount());
+    for (int i = 0; i < frames.frameCount(); i++)
+        QVERIFY(std::memcmp(recovered.constBits(i), frames.constBits(i), frames.frameBytes()) == 0);
+    journal.remove();
+}
+
+//!
+//! \brief SpriteEditorTests::saveOverMappedSspb Saves over the .sspb the frames are mapped from, with a removed frame
+//!        still held for undo, which must copy those frames first so the file can be replaced on every platform
+//!
+void SpriteEditorTests::saveOverMappedSspb() {
+    FrameStore written(32);
+    for (int i = 0; i < 3; i++)
+        written.addFrame();
+    fillPattern(written);
+    QString path = projects.filePath("mapped.sspb");
+    QVERIFY(ProjectFile::save(written, path));
+
+    FrameStore frames;
+    QVERIFY(ProjectFile::load(path, frames));
+    frames.setPixel(0, 0, 0, packPixel(255, 0, 0, 255));
+    UndoHistory history;
+    history.beginOperation();
+    history.recordRemoveFrame(frames, 1);
+    frames.removeFrame(1);
+    history.endOperation(frames);
+
+    QCOMPARE(frames.unmapFile(path), frames.frameCount());
+    history.unmapFile(frames, path);
+    QCOMPARE(frames.unmapFile(path), 0);
+    QVERIFY(ProjectFile::save(*frames.snapshot(), path));
+
+    FrameStore saved;
+    QVERIFY(ProjectFile::load(path, saved));
+    QCOMPARE(saved.frameCount(), 2);
+    QCOMPARE(saved.pixel(0, 0, 0), packPixel(255, 0, 0, 255));
+    QVERIFY(std::memcmp(saved.constBits(1), written.constBits(2), written.frameBytes()) == 0);
+
+    history.undo(frames);
+    QCOMPARE(frames.frameCount(), 3);
+    QVERIFY(std::memcmp(frames.constBits(1), written.constBits(1), written.frameBytes()) == 0);
+}
+
+//!
+//! \brief SpriteEditorTests::undoOverBudget Fills the canvas with no undo memory to spare, which must still keep the
+//!        fill it just made, and checks the fill only recorded the tiles it changed
+//!
+void SpriteEditorTests::undoOverBudget() {
+    Model model;
+    FrameEditor editor;
+    editor.startNewProject("64 x 64", &model);
+    editor.setUndoMemoryLimit(0);
+    Pixel blank = model.frames.pixel(0, 0, 0);
+
+    // Fill a 16x16 tile in the corner, walled off by a line along its edges
+    Pixel wall = FrameStore::fromColor(Qt::black);
+    for (int i = 0; i < 17; i++) {
+        model.frames.setPixel(0, i, 16, wall);
+        model.frames.setPixel(0, 16, i, wall);
+    }
+    editor.setColor(Qt::red);
+    editor.fillDriver(QPointF(0, 0));
+    QCOMPARE(model.frames.pixel(0, 0, 0), FrameStore::fromColor(Qt::red));
+    QVERIFY(editor.undoHistory().canUndo());
+    QVERIFY(editor.undoHistory().memoryUsed() < 2 * 16 * 16 * qsizetype(sizeof(Pixel)) + 1024);
+
+    // The next fill pushes the first out of the budget, but is kept itself
+    editor.setColor(Qt::blue);
+    editor.fillDriver(QPointF(40, 40));
+    QCOMPARE(model.frames.pixel(0, 40, 40), FrameStore::fromColor(Qt::blue));
+    editor.undo();
+    QCOMPARE(model.frames.pixel(0, 40, 40), blank);
+    QCOMPARE(model.frames.pixel(0, 0, 0), FrameStore::fromColor(Qt::red));
+    QVERIFY(!editor.undoHistory().canUndo());
+
+    editor.redo();
+    QCOMPARE(model.frames.pixel(0, 40, 40), FrameStore::fromColor(Qt::blue));
+}
+
+QTEST_MAIN(SpriteEditorTests)
+
+#include "tst_spriteeditor.moc"
@@ -0,0 +1,116 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "trace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThread>
+#include <vector>
+
+using std::vector;
+
+std::atomic<bool> Trace::enabled { false };
+
+//!
+//! \brief Event One traced scope, times are in nanoseconds on the trace clock
+//!
+struct Event {
+    const char *name;
+    qint64 start;
+    qint64 end;
+    quintptr thread;
+};
+
+// The ring buffer is only allocated once tracing is first turned on
+static QMutex mutex;
+static vector<Event> events;
+static quint64 recorded = 0;
+
+//!
+//! \brief traceClock Gets the monotonic clock every event is timed on
+//!
+static const QElapsedTimer &traceClock() {
+    static QElapsedTimer clock = [] { QElapsedTimer timer; timer.start(); return timer; }();
+    return clock;
+}
+
+//!
+//! \brief Trace::setEnabled Turns recording on or off. Events already recorded are kept until cleared.
+//! \param enable Whether to record
+//!
+void Trace::setEnabled(bool enable) {
+    if (enable) {
+        QMutexLocker lock(&mutex);
+        if (events.empty()) events.resize(capacity);
+        traceClock();
+    }
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+//!
+//! \brief Trace::clear Forgets every recorded event
+//!
+void Trace::clear() {
+    QMutexLocker lock(&mutex);
+    recorded = 0;
+}
+
+//!
+//! \brief Trace::now Reads the trace clock
+//! \return Nanoseconds since the clock started
+//!
+qint64 Trace::now() {
+    return traceClock().nsecsElapsed();
+}
+
+//!
+//! \brief Trace::record Adds an event, replacing the oldest once the buffer is full
+//! \param name What was timed, must outlive the trace
+//! \param start When it started, from Trace::now
+//! \param end When it finished, from Trace::now
+//!
+void Trace::record(const char *name, qint64 start, qint64 end) {
+    QMutexLocker lock(&mutex);
+    if (events.empty()) return;
+    events[recorded++ % capacity] = Event { name, start, end, quintptr(QThread::currentThreadId()) };
+}
+
+//!
+//! \brief Trace::save Writes the recorded events, oldest first, in Chrome's trace event format
+//! \param filename The JSON file to write
+//! \return Whether the file was written
+//!
+bool Trace::save(const QString &filename) {
+    QJsonArray traceEvents;
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonObject process { { "ph", "M" }, { "name", "process_name" }, { "pid", pid }, { "tid", 0 },
+                          { "args", QJsonObject { { "name", QCoreApplication::applicationName() } } } };
+    traceEvents.append(process);
+
+    {
+        QMutexLocker lock(&mutex);
+        quint64 first = recorded > quint64(capacity) ? recorded - capacity : 0;
+        for (quint64 i = first; i < recorded; i++) {
+            const Event &event = events[i % capacity];
+            // Complete events, timed in microseconds
+            traceEvents.append(QJsonObject { { "ph", "X" }, { "name", event.name }, { "cat", "editor" },
+                                             { "ts", event.start / 1000.0 }, { "dur", (event.end - event.start) / 1000.0 },
+                                             { "pid", pid }, { "tid", qint64(event.thread) } });
+        }
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QJsonObject trace { { "traceEvents", traceEvents }, { "displayTimeUnit", "ms" } };
+    return file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact)) >= 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#include "undohistory.h"
+#include <algorithm>
+#include <cstring>
+
+// How much memory the history may use before the oldest operations are dropped
+static const qsizetype defaultBudget = 64 * 1024 * 1024;
+
+//!
+//! \brief UndoHistory::UndoHistory Constructor, starts with an empty history
+//!
+UndoHistory::UndoHistory() {
+    depth = 0;
+    budget = defaultBudget;
+    used = 0;
+}
+
+//!
+//! \brief UndoHistory::beginOperation Starts recording an operation. Calls can be nested, and everything recorded
+//!        until the outermost endOperation is undone as one step.
+//!
+void UndoHistory::beginOperation() {
+    depth++;
+}
+
+//!
+//! \brief UndoHistory::touch Saves the tiles under a rectangle before a tool writes to them. Tiles already saved in
+//!        this operation are skipped, so a stroke passing over the same pixels many times saves them once.
+//! \param frames The frames about to be changed
+//! \param frame The frame about to be changed
+//! \param rect The pixels about to be changed
+//!
+void UndoHistory::touch(const FrameStore &frames, int frame, const QRect &rect) {
+    if (depth == 0)
+        return;
+
+    int size = frames.size();
+    QRect area = rect.intersected(QRect(0, 0, size, size));
+    if (area.isEmpty())
+        return;
+
+    int tilesPerRow = (size + tileSize - 1) / tileSize;
+    for (int tileY = area.top() / tileSize; tileY <= area.bottom() / tileSize; tileY++) {
+        for (int tileX = area.left() / tileSize; tileX <= area.right() / tileSize; tileX++) {
+            int tile = tileY * tilesPerRow + tileX;
+            if (!touched.insert(quint64(frame) << 32 | quint32(tile)).second)
+                continue;
+
+            // Copy the tile's pixels out row by row
+            QRect bounds = tileRect(tile, size);
+            Step step { Step::Tile, frame, tile, vector<Pixel>(qsizetype(bounds.width()) * bounds.height()), nullptr };
+            for (int y = bounds.top(); y <= bounds.bottom(); y++)
+                std::memcpy(step.pixels.data() + qsizetype(y - bounds.top()) * bounds.width(), frames.constScanLine(frame, y) + bounds.left(), bounds.width() * sizeof(Pixel));
+            pending.steps.push_back(std::move(step));
+        }
+    }
+}
+
+//!
+//! \brief UndoHistory::recordInsertFrame Records that a frame was just inserted. Its pixels are only saved if the
+//!        insert is undone.
+//! \param frame The index of the new frame
+//!
+void UndoHistory::recordInsertFrame(int frame) {
+    if (depth == 0)
+        return;
+
+    // Frame indices after this one have moved, so tiles must be saved again if touched
+    touched.clear();
+    pending.steps.push_back(Step { Step::InsertFrame, frame, 0, vector<Pixel>(), nullptr });
+}
+
+//!
+//! \brief UndoHistory::recordRemoveFrame Holds on to a frame's pixels before it is removed
+//! \param frames The frames the frame is about to be removed from
+//! \param frame The index of the frame
+//!
+void UndoHistory::recordRemoveFrame(const FrameStore &frames, int frame) {
+    if (depth == 0)
+        return;
+
+    touched.clear();
+    pending.steps.push_back(Step { Step::RemoveFrame, frame, 0, vector<Pixel>(), frames.sharedFrame(frame) });
+}
+
+//!
+//! \brief UndoHistory::endOperation Finishes recording an operation and adds it to the history. Saved tiles the tool
+//!        ended up not changing are dropped, and nothing is added if nothing changed.
+//! \param frames The frames after the operation
+//! \return Whether an operation was added to the history
+//!
+bool UndoHistory::endOperation(const FrameStore &frames) {
+    if (depth == 0 || --depth > 0)
+        return false;
+
+    touched.clear();
+    Operation operation = std::move(pending);
+    pending = Operation();
+
+    // Tile indices only line up with the frames when no frames were added or removed along the way
+    bool framesMoved = std::any_of(operation.steps.begin(), operation.steps.end(), [](const Step &step) { return step.kind != Step::Tile; });
+    if (!framesMoved) {
+        auto unchanged = [&frames](const Step &step) {
+            QRect bounds = tileRect(step.tile, frames.size());
+            for (int y = bounds.top(); y <= bounds.bottom(); y++) {
+                if (std::memcmp(step.pixels.data() + qsizetype(y - bounds.top()) * bounds.width(), frames.constScanLine(step.frame, y) + bounds.left(), bounds.width() * sizeof(Pixel)) != 0)
+                    return false;
+            }
+            return true;
+        };
+        operation.steps.erase(std::remove_if(operation.steps.begin(), operation.steps.end(), unchanged), operation.steps.end());
+    }
+    if (operation.steps.empty())
+        return false;
+
+    // A new operation replaces whatever could have been redone
+    for (const Operation &redone : redoStack)
+        used -= redone.bytes;
+    redoStack.clear();
+
+    measure(operation, frames.frameBytes());
+    used += operation.bytes;
+    undoStack.push_back(std::move(operation));
+    trim();
+    return true;
+}
+
+//!
+//! \brief UndoHistory::undo Reverses the most recent operation
+//! \param frames The frames to change
+//! \return The frame the operation started on, or -1 if there was nothing to undo
+//!
+int UndoHistory::undo(FrameStore &frames) {
+    if (undoStack.empty())
+        return -1;
+
+    Operation operation = std::move(undoStack.back());
+    undoStack.pop_back();
+    used -= operation.bytes;
+
+    for (auto step = operation.steps.rbegin(); step != operation.steps.rend(); ++step)
+        apply(*step, frames);
+    int frame = operation.steps.front().frame;
+
+    measure(operation, frames.frameBytes());
+    used += operation.bytes;
+    redoStack.push_back(std::move(operation));
+    trim();
+    return frame;
+}
+
+//!
+//! \brief UndoHistory::redo Repeats the most recently undone operation
+//! \param frames The frames to change
+//! \return The frame the operation ended on, or -1 if there was nothing to redo
+//!
+int UndoHistory::redo(FrameStore &frames) {
+    if (redoStack.empty())
+        return -1;
+
+    Operation operation = std::move(redoStack.back());
+    redoStack.pop_back();
+    used -= operation.bytes;
+
+    for (Step &step : operation.steps)
+        apply(step, frames);
+    int frame = operation.steps.back().frame;
+
+    measure(operation, frames.frameBytes());
+    used += operation.bytes;
+    undoStack.push_back(std::move(operation));
+    trim();
+    return frame;
+}
+
+//!
+//! \brief UndoHistory::clear Forgets every operation, used when the frames are replaced
+//!
+void UndoHistory::clear() {
+    depth = 0;
+    pending = Operation();
+    touched.clear();
+    undoStack.clear();
+    redoStack.clear();
+    used = 0;
+}
+
+//!
+//! \brief UndoHistory::unmapFile Copies removed frames held for undo or redo that are mapped from a file, so the file
+//!        can be replaced (see FrameStore::unmapFile). Removed frames already count in full against the budget.
+//! \param frames The frames the removed frames came from
+//! \param filename The file about to be replaced (includes path)
+//!
+void UndoHistory::unmapFile(const FrameStore &frames, const QString &filename) {
+    auto unmapSteps = [&](Operation &operation) {
+        for (Step &step : operation.steps) {
+            if (step.removed)
+                step.removed = frames.unmapped(step.removed, filename);
+        }
+    };
+    unmapSteps(pending);
+    for (Operation &operation : undoStack)
+        unmapSteps(operation);
+    for (Operation &operation : redoStack)
+        unmapSteps(operation);
+}
+
+//!
+//! \brief UndoHistory::setMemoryBudget Sets how much memory the history may use, dropping the oldest operations if it
+//!        already uses more. The newest operation to undo and to redo are kept whatever the budget.
+//! \param bytes The budget in bytes
+//!
+void UndoHistory::setMemoryBudget(qsizetype bytes) {
+    budget = qMax(qsizetype(0), bytes);
+    trim();
+}
+
+//!
+//! \brief UndoHistory::tileRect Gets the pixels a tile covers, tiles on the right and bottom edges may be smaller
+//! \param tile The tile's index, counting across then down
+//! \param size The width and height of the frame
+//! \return The tile's rectangle
+//!
+QRect UndoHistory::tileRect(int tile, int size) {
+    int tilesPerRow = (size + tileSize - 1) / tileSize;
+    int x = tile % tilesPerRow * tileSize;
+    int y = tile / tilesPerRow * tileSize;
+    return QRect(x, y, qMin(tileSize, size - x), qMin(tileSize, size - y));
+}
+
+//!
+//! \brief UndoHistory::apply Reverses one step. The step is left holding what it replaced, so applying it again
+//!        reverses it back.
+//! \param step The step to apply
+//! \param frames The frames to change
+//!
+void UndoHistory::apply(Step &step, FrameStore &frames) {
+    switch (step.kind) {
+    case Step::Tile: {
+        QRect bounds = tileRect(step.tile, frames.size());
+        for (int y = bounds.top(); y <= bounds.bottom(); y++) {
+            Pixel *line = frames.scanLine(step.frame, y) + bounds.left();
+            std::swap_ranges(line, line + bounds.width(), step.pixels.begin() + qsizetype(y - bounds.top()) * bounds.width());
+        }
+        break;
+    }
+    case Step::InsertFrame:
+        step.removed = frames.sharedFrame(step.frame);
+        frames.removeFrame(step.frame);
+        step.kind = Step::RemoveFrame;
+        break;
+    case Step::RemoveFrame:
+        frames.insertFrame(step.frame, step.removed);
+        step.removed.reset();
+        step.kind = Step::InsertFrame;
+        break;
+    }
+}
+
+//!
+//! \brief UndoHistory::measure Works out how much memory an operation holds. A removed frame counts in full, as the
+//!        history keeps its pixels alive even though it may share them.
+//! \param operation The operation to measure
+//! \param frameBytes How many bytes one frame's pixels are
+//!
+void UndoHistory::measure(Operation &operation, qsizetype frameBytes) {
+    operation.bytes = sizeof(Operation);
+    for (const Step &step : operation.steps)
+        operation.bytes += sizeof(Step) + qsizetype(step.pixels.capacity()) * sizeof(Pixel) + (step.removed ? frameBytes : 0);
+}
+
+//!
+//! \brief UndoHistory::trim Drops the oldest operations until the history fits in its budget. The newest operation
+//!        on each side is always kept, even on its own over the budget, so whatever was just done can still be undone
+//!        and whatever was just undone can still be redone.
+//!
+void UndoHistory::trim() {
+    while (used > budget && undoStack.size() > 1) {
+        used -= undoStack.front().bytes;
+        undoStack.pop_front();
+    }
+    while (used > budget && redoStack.size() > 1) {
+        used -= redoStack.front().bytes;
+        redoStack.pop_front();
+    }
+}
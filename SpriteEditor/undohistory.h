@@ -0,0 +1,86 @@
+/*
+ * Sprite Editor performance work
+ * Date: October 17, 2026
+ */
+
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include "framestore.h"
+#include <QRect>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+
+using std::vector;
+
+//!
+//! \brief UndoHistory Records each tool operation as the tiles it changed rather than as whole frames. Before a tool
+//!        writes to a tile for the first time in an operation, the tile's old pixels are copied aside; undoing swaps
+//!        them back in, which leaves the newer pixels in the history ready for redo. A removed frame is recorded by
+//!        holding on to its pixels, shared with the store, so removing a frame copies nothing. The oldest operations are
+//!        dropped once the history uses more memory than its budget, but never the newest one, however large it is.
+//!
+class UndoHistory
+{
+public:
+    static constexpr int tileSize = 16;
+
+    UndoHistory();
+
+    void beginOperation();
+    void touch(const FrameStore &frames, int frame, const QRect &rect);
+    void recordInsertFrame(int frame);
+    void recordRemoveFrame(const FrameStore &frames, int frame);
+    bool endOperation(const FrameStore &frames);
+
+    int undo(FrameStore &frames);
+    int redo(FrameStore &frames);
+    void clear();
+    void unmapFile(const FrameStore &frames, const QString &filename);
+
+    bool canUndo() const { return !undoStack.empty(); }
+    bool canRedo() const { return !redoStack.empty(); }
+    bool isRecording() const { return depth > 0; }
+
+    void setMemoryBudget(qsizetype bytes);
+    qsizetype memoryBudget() const { return budget; }
+    qsizetype memoryUsed() const { return used; }
+
+private:
+    //!
+    //! \brief Step One change to the frames. Applying a step reverses it and turns it into the step that redoes it.
+    //!
+    struct Step {
+        enum Kind { Tile, InsertFrame, RemoveFrame };
+        Kind kind;
+        int frame;
+        int tile;
+        vector<Pixel> pixels;
+        FrameStore::SharedFrame removed;
+    };
+
+    //!
+    //! \brief Operation Everything one use of a tool changed, in the order it happened
+    //!
+    struct Operation {
+        vector<Step> steps;
+        qsizetype bytes = 0;
+    };
+
+    int depth;
+    Operation pending;
+    std::unordered_set<quint64> touched;
+    std::deque<Operation> undoStack;
+    std::deque<Operation> redoStack;
+    qsizetype budget;
+    qsizetype used;
+
+    static QRect tileRect(int tile, int size);
+    static qsizetype stepBytes(const Step &step);
+    static void apply(Step &step, FrameStore &frames);
+    static void measure(Operation &operation, qsizetype frameBytes);
+    void trim();
+};
+
+#endif // UNDOHISTORY_H